@@ -1,222 +1,176 @@
 #pragma once
 #include "tile.h"
-#include <SFML/Graphics.hpp>
+#include "minecount.h"
+#include "rng.h"
+#include <algorithm>
+#include <cstdint>
 #include <vector>
-#include <random>
 
 using namespace std;
 
 class Board {
 public:
-    // 2D vector of tiles and sprites for filling the board
-    vector<vector<Tile*>> tiles2D;
-    vector<vector<sf::Sprite>> baseSprites2D;
-    vector<vector<sf::Sprite>> flagSprites2D;
-    vector<vector<sf::Sprite>> mineSprites2D;
-    vector<vector<sf::Sprite>> numberSprites2D;
-    map<string, sf::Texture> boardTextures;     // The map of textures for easy access
+    // Tiles are stored row-major in one contiguous array with a one-tile border on every side,
+    // so every playable tile has all eight neighbors and no edge cases are needed.
+    vector<Tile> tiles;
+    vector<int> mineIndices;    // Indices of every mined tile
+    vector<uint64_t> mineRows;  // The mine layout as one padded bitmask per row, used to count neighbors
     int _rows;
     int _cols;
     int _mines;
+    int _stride;                // Tiles per stored row (columns plus the two border tiles)
+    int _rowWords;              // Words per padded bitmask row
+    int neighborOffsets[8];     // Index offsets from a tile to each of its eight neighbors
     int nonMinesRevealed = 0;
     int minesFlagged = 0;
+    bool minesPlaced = false;
+    uint64_t seed = 0;          // The seed the mines were placed with
 
-    // Construct the board
-    Board(int rows, int cols, int mines, map<string, sf::Texture>& textures) {
+    // Construct an empty board. Mines are placed by placeMines, normally on the first click.
+    Board(int rows, int cols, int mines) {
         _rows = rows;
         _cols = cols;
-        _mines = mines;
-        boardTextures = textures;
-
-        // Initialize Tiles and their respective sprites
-        for (int i = 0; i < _rows; i++) {
-            vector<Tile*> tileRow;
-            vector<sf::Sprite> spriteRow;
-            vector<sf::Sprite> flagRow;
-            vector<sf::Sprite> mineRow;
-            vector<sf::Sprite> numRow;
-            for (int j = 0; j < _cols; j++) {
-                // Create a new tile
-                Tile* tile = new Tile();
-
-                // Add the tile to the row
-                tileRow.push_back(tile);    // A single row of tiles in one vector
-
-                // Initializes all tiles to hidden.
-                sf::Sprite sprite;
-                sprite.setTexture(boardTextures["tile_hidden"]);
-                spriteRow.push_back(sprite);
-
-                // Empty flag sprites to begin with.
-                sf::Sprite flagSprite;
-                flagRow.push_back(flagSprite);
-
-                // Empty mine sprites as well
-                sf::Sprite mineSprite;
-                mineRow.push_back(mineSprite);
-
-                // Empty number sprites
-                sf::Sprite numSprite;
-                numRow.push_back(numSprite);
+        _mines = playableMines(mines);
+        _stride = cols + 2;
+        _rowWords = mineRowWords(cols);
+
+        // Neighbors in the same order the old adjacency vectors used: top row, sides, bottom row.
+        int offsets[8] = {-_stride - 1, -_stride, -_stride + 1, -1, 1, _stride - 1, _stride, _stride + 1};
+        for (int i = 0; i < 8; i++) {
+            neighborOffsets[i] = offsets[i];
+        }
+
+        // All tiles start hidden. Border tiles count as revealed so reveals stop at the edge.
+        tiles.assign((size_t)(_rows + 2) * _stride, Tile());
+        for (int i = 0; i < (int)tiles.size(); i++) {
+            int row = i / _stride;
+            int col = i % _stride;
+            if (row == 0 || row == _rows + 1 || col == 0 || col == _cols + 1) {
+                tiles[i].bits = Tile::BORDER | Tile::REVEALED;
             }
-            tiles2D.push_back(tileRow);
-            baseSprites2D.push_back(spriteRow);
-            flagSprites2D.push_back(flagRow);
-            mineSprites2D.push_back(mineRow);
-            numberSprites2D.push_back(numRow);
         }
+        mineRows.assign((size_t)(_rows + 2) * _rowWords, 0);
+    }
 
-        // Randomly place mines until the mines quota is reached.
-        // ***From Functor Slides***
-        mt19937 mt(time(0));
-        uniform_int_distribution<int> distRow(0, _rows - 1);
-        uniform_int_distribution<int> distCol(0, _cols - 1);
-
-        int minesToPlace = _mines;
-        while (minesToPlace > 0) {
-            // Generate random numbers
-            int i = distRow(mt);
-            int j = distCol(mt);
-
-            // Check if the tile already has a mine and if not, place it.
-            if (!(tiles2D[i][j])->mined) {
-                tiles2D[i][j]->mined = true;
-                minesToPlace--;
-                sf::Sprite mineSprite;
-                mineSprite.setTexture(boardTextures["mine"]);
-                mineSprites2D[i][j] = mineSprite;
+    // Randomly places the mines in O(mines) with Floyd's sampling, keeping the safe tile (and its 3x3
+    // neighborhood if asked) free of mines. A safe row of -1 places mines anywhere.
+    // The same seed and safe tile always give the same board.
+    void placeMines(uint64_t mineSeed, int safeRow = -1, int safeCol = -1, bool safeNeighborhood = false) {
+        seed = mineSeed;
+        minesPlaced = true;
+        Rng rng(mineSeed);
+
+        // Cells that must stay safe, as sorted row-major positions
+        int excluded[9];
+        int excludedCount = 0;
+        if (safeRow >= 0) {
+            int radius = safeNeighborhood ? 1 : 0;
+            // Fall back to only the clicked tile if the neighborhood leaves too little room for the mines
+            if (radius == 1 && _rows * _cols - 9 < _mines) {
+                radius = 0;
+            }
+            for (int row = safeRow - radius; row <= safeRow + radius; row++) {
+                for (int col = safeCol - radius; col <= safeCol + radius; col++) {
+                    if (row >= 0 && row < _rows && col >= 0 && col < _cols) {
+                        excluded[excludedCount++] = row * _cols + col;
+                    }
+                }
             }
         }
 
-        findNeighbors(_rows, _cols);    // Finds neighbors for each tile
+        // _mines leaves room for the clicked tile, and the neighborhood falls back to it, so the mines always fit.
+        // The count is only limited here for a board placed with no safe tile, and _mines is left as configured.
+        int candidates = _rows * _cols - excludedCount;
+        int placing = min(_mines, candidates);
+        mineIndices.reserve(placing);
+
+        // Floyd's algorithm: for each j in the last placing candidates, pick t in [0, j] and take j instead
+        // if t is already mined. Each subset of candidates is equally likely.
+        for (int j = candidates - placing; j < candidates; j++) {
+            int position = candidatePosition((int)rng.below((uint64_t)j + 1), excluded, excludedCount);
+            if (tileAt(position / _cols, position % _cols).isMined()) {
+                position = candidatePosition(j, excluded, excludedCount);
+            }
+            int row = position / _cols;
+            int col = position % _cols;
+            tileAt(row, col).setMined(true);
+            setMineBit(row, col);
+            mineIndices.push_back(index(row, col));
+        }
 
-        setNumberSprites(); // Set the number indicators for every tile dependent on the mine locations.
+        countAdjacentMines();   // Counts the neighboring mines of every tile
     }
 
-    // Deallocates the tiles
-    void eraseTiles() {
+    // Empties the board in place so it can be reused for another game without reallocating.
+    void clearMines(int mines) {
         for (int row = 0; row < _rows; row++) {
-            tiles2D[row].clear();
+            Tile* rowStart = &tiles[index(row, 0)];
+            fill(rowStart, rowStart + _cols, Tile());
         }
+        fill(mineRows.begin(), mineRows.end(), 0);
+        mineIndices.clear();
+        _mines = playableMines(mines);
+        nonMinesRevealed = 0;
+        minesFlagged = 0;
+        minesPlaced = false;
+        seed = 0;
     }
 
-    // Determines where the number indicator sprites will be located
-    void setNumberSprites() {
-        // Have every tile count its adjacent mines
-        for (int i = 0; i < tiles2D.size(); i++) {
-            for (int j = 0; j < tiles2D[0].size(); j++) {
-                int count = tiles2D[i][j]->countAdjacentMines();
-                // Set the sprite dependent on what the count is
-                sf::Sprite numSprite;
-                if (count == 1) {
-                    numSprite.setTexture(boardTextures["number_1"]);
-                }
-                else if (count == 2) {
-                    numSprite.setTexture(boardTextures["number_2"]);
-                }
-                else if (count == 3) {
-                    numSprite.setTexture(boardTextures["number_3"]);
-                }
-                else if (count == 4) {
-                    numSprite.setTexture(boardTextures["number_4"]);
-                }
-                else if (count == 5) {
-                    numSprite.setTexture(boardTextures["number_5"]);
-                }
-                else if (count == 6) {
-                    numSprite.setTexture(boardTextures["number_6"]);
-                }
-                else if (count == 7) {
-                    numSprite.setTexture(boardTextures["number_7"]);
-                }
-                else if (count == 8) {
-                    numSprite.setTexture(boardTextures["number_8"]);
-                }
+    // The mines a board of this size can hold: every tile but the first click
+    int playableMines(int mines) const {
+        return max(0, min(mines, _rows * _cols - 1));
+    }
 
-                numberSprites2D[i][j] = numSprite;
-            }
+    // Maps the n-th candidate to its row-major position by skipping the excluded positions
+    static int candidatePosition(int n, const int excluded[], int excludedCount) {
+        for (int i = 0; i < excludedCount && n >= excluded[i]; i++) {
+            n++;
         }
+        return n;
     }
 
-    // Passes any existing neighboring tiles to each tile
-    void findNeighbors(int _rows, int _cols) {
+    // Index of a playable tile within the padded tile array
+    int index(int row, int col) const {
+        return (row + 1) * _stride + (col + 1);
+    }
 
-        // Iterate over the 2D vector
-        for (int i = 0; i < _rows; i++) {
+    // Board row of a tile index
+    int rowOf(int index) const {
+        return index / _stride - 1;
+    }
 
-            for (int j = 0; j < _cols; j++) {
-                // For tiles in the top row
-                if (i == 0) {
-                    // For tiles in the first column
-                    if (j == 0) {
-                        tiles2D[i][j]->adjacentTiles[4] = tiles2D[i][j + 1];
-                        tiles2D[i][j]->adjacentTiles[6] = tiles2D[i + 1][j];
-                        tiles2D[i][j]->adjacentTiles[7] = tiles2D[i + 1][j + 1];
-                    }
-                        // For tiles in the last column
-                    else if (j == _cols - 1) {
-                        tiles2D[i][j]->adjacentTiles[3] = tiles2D[i][j - 1];
-                        tiles2D[i][j]->adjacentTiles[5] = tiles2D[i + 1][j - 1];
-                        tiles2D[i][j]->adjacentTiles[6] = tiles2D[i + 1][j];
-                    }
-                    else {
-                        tiles2D[i][j]->adjacentTiles[3] = tiles2D[i][j - 1];
-                        tiles2D[i][j]->adjacentTiles[4] = tiles2D[i][j + 1];
-                        tiles2D[i][j]->adjacentTiles[5] = tiles2D[i + 1][j - 1];
-                        tiles2D[i][j]->adjacentTiles[6] = tiles2D[i + 1][j];
-                        tiles2D[i][j]->adjacentTiles[7] = tiles2D[i + 1][j + 1];
-                    }
-                }
-                // For tiles in the bottom row
-                else if (i == _rows - 1) {
-                    // For tiles in the first column
-                    if (j == 0) {
-                        tiles2D[i][j]->adjacentTiles[1] = tiles2D[i - 1][j];
-                        tiles2D[i][j]->adjacentTiles[2] = tiles2D[i - 1][j + 1];
-                        tiles2D[i][j]->adjacentTiles[4] = tiles2D[i][j + 1];
-                    }
-                        // For tiles in the last column
-                    else if (j == _cols - 1) {
-                        tiles2D[i][j]->adjacentTiles[0] = tiles2D[i - 1][j - 1];
-                        tiles2D[i][j]->adjacentTiles[1] = tiles2D[i - 1][j];
-                        tiles2D[i][j]->adjacentTiles[3] = tiles2D[i][j - 1];
-                    }
-                    else {
-                        tiles2D[i][j]->adjacentTiles[0] = tiles2D[i - 1][j - 1];
-                        tiles2D[i][j]->adjacentTiles[1] = tiles2D[i - 1][j];
-                        tiles2D[i][j]->adjacentTiles[2] = tiles2D[i - 1][j + 1];
-                        tiles2D[i][j]->adjacentTiles[3] = tiles2D[i][j - 1];
-                        tiles2D[i][j]->adjacentTiles[4] = tiles2D[i][j + 1];
-                    }
-                }
-                // For tiles on the left side
-                else if ((j == 0) && (i > 0) && (i < _rows - 1)) {
-                    tiles2D[i][j]->adjacentTiles[1] = tiles2D[i - 1][j];
-                    tiles2D[i][j]->adjacentTiles[2] = tiles2D[i - 1][j + 1];
-                    tiles2D[i][j]->adjacentTiles[4] = tiles2D[i][j + 1];
-                    tiles2D[i][j]->adjacentTiles[6] = tiles2D[i + 1][j];
-                    tiles2D[i][j]->adjacentTiles[7] = tiles2D[i + 1][j + 1];
-                }
-                // For tiles on the right side
-                else if ((j == _cols - 1) && (i > 0) && (i < _rows - 1)) {
-                    tiles2D[i][j]->adjacentTiles[0] = tiles2D[i - 1][j - 1];
-                    tiles2D[i][j]->adjacentTiles[1] = tiles2D[i - 1][j];
-                    tiles2D[i][j]->adjacentTiles[3] = tiles2D[i][j - 1];
-                    tiles2D[i][j]->adjacentTiles[5] = tiles2D[i + 1][j - 1];
-                    tiles2D[i][j]->adjacentTiles[6] = tiles2D[i + 1][j];
-                }
-                // For all other tiles
-                else {
-                    tiles2D[i][j]->adjacentTiles[0] = tiles2D[i - 1][j - 1];
-                    tiles2D[i][j]->adjacentTiles[1] = tiles2D[i - 1][j];
-                    tiles2D[i][j]->adjacentTiles[2] = tiles2D[i - 1][j + 1];
-                    tiles2D[i][j]->adjacentTiles[3] = tiles2D[i][j - 1];
-                    tiles2D[i][j]->adjacentTiles[4] = tiles2D[i][j + 1];
-                    tiles2D[i][j]->adjacentTiles[5] = tiles2D[i + 1][j - 1];
-                    tiles2D[i][j]->adjacentTiles[6] = tiles2D[i + 1][j];
-                    tiles2D[i][j]->adjacentTiles[7] = tiles2D[i + 1][j + 1];
-                }
-            }
-        }
+    // Board column of a tile index
+    int colOf(int index) const {
+        return index % _stride - 1;
+    }
+
+    Tile& tileAt(int row, int col) {
+        return tiles[index(row, col)];
+    }
+
+    const Tile& tileAt(int row, int col) const {
+        return tiles[index(row, col)];
+    }
+
+    // Memory used by the game state of the board, per playable tile.
+    double bytesPerCell() const {
+        size_t bytes = tiles.size() * sizeof(Tile) + mineRows.size() * sizeof(uint64_t);
+        return (double)bytes / ((double)_rows * _cols);
+    }
+
+    // Marks a mine in the row bitmasks
+    void setMineBit(int row, int col) {
+        mineRows[(size_t)(row + 1) * _rowWords + 1 + col / 64] |= (uint64_t)1 << (col % 64);
+    }
+
+    // Removes a mine from the row bitmasks
+    void clearMineBit(int row, int col) {
+        mineRows[(size_t)(row + 1) * _rowWords + 1 + col / 64] &= ~((uint64_t)1 << (col % 64));
+    }
+
+    // Stores the number of adjacent mines in every playable tile, computed from the row bitmasks
+    // 64 tiles at a time (256 with AVX2).
+    void countAdjacentMines() {
+        countMinesFromRows(mineRows, _rows, _cols, &tiles[index(0, 0)], _stride);
     }
-};
\ No newline at end of file
+};
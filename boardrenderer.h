@@ -0,0 +1,272 @@
+#pragma once
+#include "game.h"
+#include "textures.h"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// Draws the board from the game state with one vertex array of textured quads per layer.
+// The board is kept rendered in a texture, and only the tiles the game reports as changed are
+// drawn into it again, so a frame where nothing changed is a single textured quad. Boards too large for a
+// texture are drawn from the layers, submitting only the rows and columns inside the target's view.
+class BoardRenderer {
+public:
+    // The tile images the quads are drawn with
+    enum AtlasTile { HIDDEN, REVEALED, FLAG, MINE, NUMBER_1, NUMBER_2, NUMBER_3, NUMBER_4,
+                     NUMBER_5, NUMBER_6, NUMBER_7, NUMBER_8, EMPTY, ATLAS_TILE_COUNT };
+
+    const sf::Texture* atlas = nullptr;         // The shared texture atlas, owned by Textures
+    sf::Vector2f tileOrigins[ATLAS_TILE_COUNT]; // Top left corner of each tile image in the atlas
+    sf::VertexArray baseLayer;      // One hidden or revealed quad per tile
+    sf::VertexArray markLayer;      // One flag, number or empty quad per tile
+    sf::VertexArray mineLayer;      // One mine or empty quad per tile
+    sf::VertexArray pauseLayer;     // All tiles revealed and empty, shown while the game is paused
+    sf::VertexArray dirtyBase;      // Base quads of the changed tiles, drawn into the cache
+    sf::VertexArray dirtyOverlay;   // Flag, number and mine quads of the changed tiles
+    sf::RenderTexture cache;        // The board as last drawn
+    sf::Sprite cacheSprite;
+    bool cacheEnabled = false;      // False when the board is larger than the biggest texture the GPU allows
+    int tileSize = 32;
+    int _rows = 0;
+    int _cols = 0;
+
+    // Draws with the tile images of the shared atlas. Must be called before the first resize.
+    void useAtlas(const Textures& textures) {
+        TextureId ids[ATLAS_TILE_COUNT] = {TEXTURE_TILE_HIDDEN, TEXTURE_TILE_REVEALED, TEXTURE_FLAG, TEXTURE_MINE,
+                                           TEXTURE_NUMBER_1, TEXTURE_NUMBER_2, TEXTURE_NUMBER_3, TEXTURE_NUMBER_4,
+                                           TEXTURE_NUMBER_5, TEXTURE_NUMBER_6, TEXTURE_NUMBER_7, TEXTURE_NUMBER_8,
+                                           TEXTURE_EMPTY};
+        atlas = &textures.atlas;
+        for (int i = 0; i < ATLAS_TILE_COUNT; i++) {
+            const sf::IntRect& rect = textures.rect(ids[i]);
+            tileOrigins[i] = sf::Vector2f((float)rect.left, (float)rect.top);
+        }
+        needsFullRedraw = true;
+    }
+
+    // Sizes the layers and the cache for a board and positions every quad.
+    void resize(int rows, int cols) {
+        _rows = rows;
+        _cols = cols;
+        size_t vertices = (size_t)rows * cols * 4;
+        for (sf::VertexArray* layer : {&baseLayer, &markLayer, &mineLayer, &pauseLayer}) {
+            layer->setPrimitiveType(sf::Quads);
+            layer->resize(vertices);
+        }
+        dirtyBase.setPrimitiveType(sf::Quads);
+        dirtyOverlay.setPrimitiveType(sf::Quads);
+
+        for (int row = 0; row < rows; row++) {
+            for (int col = 0; col < cols; col++) {
+                size_t quad = ((size_t)row * cols + col) * 4;
+                for (sf::VertexArray* layer : {&baseLayer, &markLayer, &mineLayer, &pauseLayer}) {
+                    setQuadPosition(&(*layer)[quad], row, col);
+                }
+                setQuadTexture(&pauseLayer[quad], REVEALED);
+            }
+        }
+
+        unsigned width = (unsigned)(cols * tileSize);
+        unsigned height = (unsigned)(rows * tileSize);
+        unsigned maxSize = sf::Texture::getMaximumSize();
+        cacheEnabled = width <= maxSize && height <= maxSize && cache.create(width, height);
+        if (cacheEnabled) {
+            cacheSprite.setTexture(cache.getTexture(), true);
+        }
+        else {
+            cout << "Board is too large to cache in a texture, drawing it directly." << endl;
+        }
+        needsFullRedraw = true;
+    }
+
+    // Forces the next update to redraw every tile.
+    void invalidate() {
+        needsFullRedraw = true;
+    }
+
+    // Brings the quads and the cached board up to date with the game and takes the game's changes.
+    // Mines are shown when the game is lost, or in debug mode while the game has not been won.
+    void update(Game& game, bool debugMode, bool paused) {
+        if (game.rows() != _rows || game.cols() != _cols) {
+            resize(game.rows(), game.cols());
+        }
+
+        bool showMines = game.gameLost || (debugMode && !game.gameWon);
+        bool minesToggled = showMines != showingMines;
+        if (game.boardChanged || paused != showingPause) {
+            needsFullRedraw = true;
+        }
+        showingMines = showMines;
+        showingPause = paused;
+
+        const vector<int>& mineIndices = game.board.mineIndices;
+        size_t changes = game.changedTiles.size() + (minesToggled ? mineIndices.size() : 0);
+
+        // Large batches are cheaper to draw as whole layers than tile by tile
+        if (needsFullRedraw || changes > (size_t)_rows * _cols / 4) {
+            for (int row = 0; row < _rows; row++) {
+                for (int col = 0; col < _cols; col++) {
+                    updateTile(game, game.board.index(row, col));
+                }
+            }
+            redrawCache();
+        }
+        else if (changes > 0) {
+            dirtyBase.clear();
+            dirtyOverlay.clear();
+            for (int index : game.changedTiles) {
+                updateDirtyTile(game, index);
+            }
+            if (minesToggled) {
+                for (int index : mineIndices) {
+                    updateDirtyTile(game, index);
+                }
+            }
+            drawDirtyToCache();
+        }
+
+        game.clearChanges();
+    }
+
+    // Draws the board: the cached texture, or the layers directly if the board could not be cached.
+    void draw(sf::RenderTarget& target) const {
+        if (cacheEnabled) {
+            target.draw(cacheSprite);
+        }
+        else {
+            drawLayers(target);
+        }
+    }
+
+private:
+    bool needsFullRedraw = true;
+    bool showingMines = false;
+    bool showingPause = false;
+
+    void setQuadPosition(sf::Vertex* quad, int row, int col) const {
+        float x = (float)(col * tileSize);
+        float y = (float)(row * tileSize);
+        float size = (float)tileSize;
+        quad[0].position = sf::Vector2f(x, y);
+        quad[1].position = sf::Vector2f(x + size, y);
+        quad[2].position = sf::Vector2f(x + size, y + size);
+        quad[3].position = sf::Vector2f(x, y + size);
+    }
+
+    void setQuadTexture(sf::Vertex* quad, int atlasTile) const {
+        sf::Vector2f origin = tileOrigins[atlasTile];
+        float size = (float)tileSize;
+        quad[0].texCoords = origin;
+        quad[1].texCoords = origin + sf::Vector2f(size, 0);
+        quad[2].texCoords = origin + sf::Vector2f(size, size);
+        quad[3].texCoords = origin + sf::Vector2f(0, size);
+    }
+
+    // Sets the textures of the quads of one tile from its state. Returns the first vertex of its quads.
+    size_t updateTile(const Game& game, int index) {
+        int row = game.board.rowOf(index);
+        int col = game.board.colOf(index);
+        const Tile& tile = game.board.tiles[index];
+        size_t quad = ((size_t)row * _cols + col) * 4;
+
+        // Mines are uncovered once the game is lost
+        bool revealed = tile.isRevealed() || (game.gameLost && tile.isMined());
+        setQuadTexture(&baseLayer[quad], revealed ? REVEALED : HIDDEN);
+
+        int mark = EMPTY;
+        if (tile.isFlagged()) {
+            mark = FLAG;
+        }
+        else if (tile.isRevealed() && !tile.isMined() && tile.adjacentMineCount() > 0) {
+            mark = NUMBER_1 + tile.adjacentMineCount() - 1;
+        }
+        setQuadTexture(&markLayer[quad], mark);
+        setQuadTexture(&mineLayer[quad], showingMines && tile.isMined() ? MINE : EMPTY);
+        return quad;
+    }
+
+    // Updates one changed tile and queues its quads to be drawn into the cache.
+    void updateDirtyTile(const Game& game, int index) {
+        size_t quad = updateTile(game, index);
+        if (showingPause) {
+            return;
+        }
+        for (int i = 0; i < 4; i++) {
+            dirtyBase.append(baseLayer[quad + i]);
+        }
+        for (int i = 0; i < 4; i++) {
+            dirtyOverlay.append(markLayer[quad + i]);
+        }
+        for (int i = 0; i < 4; i++) {
+            dirtyOverlay.append(mineLayer[quad + i]);
+        }
+    }
+
+    // The tiles inside the target's view, clamped to the board. Returns false if none are.
+    bool visibleRange(const sf::RenderTarget& target, int& firstRow, int& lastRow, int& firstCol, int& lastCol) const {
+        const sf::View& view = target.getView();
+        float left = view.getCenter().x - view.getSize().x / 2;
+        float top = view.getCenter().y - view.getSize().y / 2;
+        firstCol = max(0, (int)floor(left / tileSize));
+        lastCol = min(_cols - 1, (int)floor((left + view.getSize().x) / tileSize));
+        firstRow = max(0, (int)floor(top / tileSize));
+        lastRow = min(_rows - 1, (int)floor((top + view.getSize().y) / tileSize));
+        return firstRow <= lastRow && firstCol <= lastCol;
+    }
+
+    // Draws the visible part of a layer: one draw of whole rows if every column is visible, else one per row.
+    void drawVisible(sf::RenderTarget& target, const sf::VertexArray& layer, const sf::RenderStates& states,
+                     int firstRow, int lastRow, int firstCol, int lastCol) const {
+        if (firstCol == 0 && lastCol == _cols - 1) {
+            size_t first = (size_t)firstRow * _cols * 4;
+            target.draw(&layer[first], (size_t)(lastRow - firstRow + 1) * _cols * 4, sf::Quads, states);
+            return;
+        }
+        for (int row = firstRow; row <= lastRow; row++) {
+            size_t first = ((size_t)row * _cols + firstCol) * 4;
+            target.draw(&layer[first], (size_t)(lastCol - firstCol + 1) * 4, sf::Quads, states);
+        }
+    }
+
+    void drawLayers(sf::RenderTarget& target) const {
+        int firstRow, lastRow, firstCol, lastCol;
+        if (!visibleRange(target, firstRow, lastRow, firstCol, lastCol)) {
+            return;
+        }
+        sf::RenderStates states(atlas);
+        if (showingPause) {
+            drawVisible(target, pauseLayer, states, firstRow, lastRow, firstCol, lastCol);
+            return;
+        }
+        for (const sf::VertexArray* layer : {&baseLayer, &markLayer, &mineLayer}) {
+            drawVisible(target, *layer, states, firstRow, lastRow, firstCol, lastCol);
+        }
+    }
+
+    void redrawCache() {
+        needsFullRedraw = false;
+        if (!cacheEnabled) {
+            return;
+        }
+        cache.clear(sf::Color::Transparent);
+        drawLayers(cache);
+        cache.display();
+    }
+
+    // The base quads replace the old pixels of the changed tiles, then the overlays are blended on top.
+    void drawDirtyToCache() {
+        if (!cacheEnabled || dirtyBase.getVertexCount() == 0) {
+            return;
+        }
+        sf::RenderStates states(atlas);
+        states.blendMode = sf::BlendNone;
+        cache.draw(dirtyBase, states);
+        states.blendMode = sf::BlendAlpha;
+        cache.draw(dirtyOverlay, states);
+        cache.display();
+    }
+};
@@ -0,0 +1,136 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// A scrollable, zoomable view of the board, shown in the area of the window above the HUD.
+// Boards larger than the window are played by panning it, and window pixels are mapped to tiles through it.
+// Zoom is in board pixels per window pixel, so 1 shows tiles at their 32 pixels and 2 at 16 pixels.
+class Camera {
+public:
+    static constexpr float MIN_ZOOM = 0.5f;     // Tiles shown at 64 pixels
+    static constexpr float MAX_ZOOM = 8.0f;     // Tiles shown at 4 pixels
+    static constexpr float ZOOM_STEP = 1.25f;   // Zoom change per wheel notch or key press
+    static const int PAN_STEP = 96;             // Window pixels panned per key press
+    static const int DRAG_THRESHOLD = 4;        // Window pixels the mouse must move before a press becomes a drag
+
+    sf::View view;
+    float boardWidth;           // In board pixels
+    float boardHeight;
+    int areaWidth;              // The board area at the top left of the window, in window pixels
+    int areaHeight;
+    int windowWidth;
+    int windowHeight;
+    float zoom = 1;
+    sf::Vector2f center;        // Board pixel at the center of the area
+    sf::Vector2f topLeft;       // Board pixel at the top left corner of the area, snapped to whole window pixels
+
+    // Mouse drag state
+    bool pressed = false;
+    bool dragging = false;
+    sf::Vector2i pressPosition;
+    sf::Vector2i lastPosition;
+
+    Camera(float boardWidth, float boardHeight, int areaWidth, int areaHeight, int windowWidth, int windowHeight)
+        : boardWidth(boardWidth), boardHeight(boardHeight), areaWidth(areaWidth), areaHeight(areaHeight),
+          windowWidth(windowWidth), windowHeight(windowHeight) {
+        center = sf::Vector2f(boardWidth / 2, boardHeight / 2);
+        if (boardWidth > areaWidth) {
+            center.x = areaWidth / 2.0f;
+        }
+        if (boardHeight > areaHeight) {
+            center.y = areaHeight / 2.0f;
+        }
+        updateView();
+    }
+
+    // Whether a window pixel is inside the board area
+    bool contains(int x, int y) const {
+        return x >= 0 && x < areaWidth && y >= 0 && y < areaHeight;
+    }
+
+    sf::Vector2f toBoard(int x, int y) const {
+        return sf::Vector2f(topLeft.x + x * zoom, topLeft.y + y * zoom);
+    }
+
+    // The tile under a window pixel. Returns false outside the board area. The tile can be off the board.
+    bool tileAt(int x, int y, int tileSize, int& row, int& col) const {
+        if (!contains(x, y)) {
+            return false;
+        }
+        sf::Vector2f position = toBoard(x, y);
+        row = (int)floor(position.y / tileSize);
+        col = (int)floor(position.x / tileSize);
+        return true;
+    }
+
+    // Moves the view by a distance in window pixels.
+    void pan(float dx, float dy) {
+        center.x += dx * zoom;
+        center.y += dy * zoom;
+        updateView();
+    }
+
+    // Zooms by whole steps, in for positive steps, keeping the board pixel under the window pixel in place.
+    void zoomAt(float steps, int x, int y) {
+        sf::Vector2f anchor = toBoard(x, y);
+        float fitZoom = max(boardWidth / areaWidth, boardHeight / areaHeight);
+        float maxZoom = max(1.0f, min(MAX_ZOOM, fitZoom));
+        zoom = min(max(zoom * pow(ZOOM_STEP, -steps), MIN_ZOOM), maxZoom);
+        // Snap to 1 when passing it, so tiles can go back to being drawn pixel for pixel
+        if (fabs(zoom - 1) < 0.05f) {
+            zoom = 1;
+        }
+        center.x = anchor.x - (x - areaWidth / 2.0f) * zoom;
+        center.y = anchor.y - (y - areaHeight / 2.0f) * zoom;
+        updateView();
+    }
+
+    // A left press on the board area starts a possible drag.
+    void press(int x, int y) {
+        pressed = true;
+        dragging = false;
+        pressPosition = sf::Vector2i(x, y);
+        lastPosition = pressPosition;
+    }
+
+    // Pans with the mouse once it has moved far enough from the press.
+    void moveTo(int x, int y) {
+        if (!pressed) {
+            return;
+        }
+        if (!dragging && abs(x - pressPosition.x) + abs(y - pressPosition.y) < DRAG_THRESHOLD) {
+            return;
+        }
+        dragging = true;
+        pan((float)(lastPosition.x - x), (float)(lastPosition.y - y));
+        lastPosition = sf::Vector2i(x, y);
+    }
+
+    // Ends a press. Returns true if it was a drag, false if it was a click.
+    bool release() {
+        bool wasDrag = dragging;
+        pressed = false;
+        dragging = false;
+        return wasDrag;
+    }
+
+private:
+    // Keeps the board in view, centered along any axis it does not fill, and rebuilds the view.
+    void updateView() {
+        float visibleWidth = areaWidth * zoom;
+        float visibleHeight = areaHeight * zoom;
+        center.x = boardWidth <= visibleWidth ? boardWidth / 2 : min(max(center.x, visibleWidth / 2), boardWidth - visibleWidth / 2);
+        center.y = boardHeight <= visibleHeight ? boardHeight / 2 : min(max(center.y, visibleHeight / 2), boardHeight - visibleHeight / 2);
+
+        // Whole window pixels keep the tiles sharp at a zoom of 1
+        topLeft.x = round((center.x - visibleWidth / 2) / zoom) * zoom;
+        topLeft.y = round((center.y - visibleHeight / 2) / zoom) * zoom;
+
+        view.setSize(visibleWidth, visibleHeight);
+        view.setCenter(topLeft.x + visibleWidth / 2, topLeft.y + visibleHeight / 2);
+        view.setViewport(sf::FloatRect(0, 0, (float)areaWidth / windowWidth, (float)areaHeight / windowHeight));
+    }
+};
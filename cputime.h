@@ -0,0 +1,34 @@
+#pragma once
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+using namespace std;
+
+// Processor time used by this process so far, user and kernel, in seconds. clock() would be simpler, but on
+// Windows it returns elapsed wall time, which makes an idle process look fully busy.
+inline double processCpuSeconds() {
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    // FILETIMEs count 100 ns intervals
+    auto seconds = [](const FILETIME& time) {
+        return (double)(((unsigned long long)time.dwHighDateTime << 32) | time.dwLowDateTime) / 1e7;
+    };
+    return seconds(kernel) + seconds(user);
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (double)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+           + (double)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#endif
+}
@@ -0,0 +1,608 @@
+#pragma once
+#include "minecount.h"
+#include "rng.h"
+#include "tile.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Endless mode: a board with no edges, split into square chunks that are only created when the game
+// touches them. A chunk's mines depend only on the seed and the chunk's coordinates, so a chunk the player
+// never changed can be dropped and created again identically. Chunks the player changed keep only their
+// revealed and flagged bits (2 bits per tile) once they are evicted, or a single byte if every safe tile was
+// revealed, and are rebuilt when touched again. Past maxPackedChunks, packed chunks are spilled to a temporary
+// file and only their place in it is kept in memory.
+
+// A tile position on the endless board. Rows and columns can be negative.
+struct Cell {
+    int row;
+    int col;
+};
+
+class EndlessBoard {
+public:
+    static const int CHUNK_SHIFT = 5;
+    static const int CHUNK_SIZE = 1 << CHUNK_SHIFT;     // Tiles per chunk side
+    static const int CHUNK_MASK = CHUNK_SIZE - 1;
+    static const int CHUNK_TILES = CHUNK_SIZE * CHUNK_SIZE;
+    static const int MAX_RESIDENT_CHUNKS = 1024;        // Chunks kept whole before far ones are evicted (1 MB of tiles)
+    static const int KEEP_RADIUS = 8;                   // Chunks this close to the focus are never evicted
+
+    struct Chunk {
+        Tile tiles[CHUNK_TILES];        // Row-major
+        uint32_t mines[CHUNK_SIZE];     // Mine bits of each row, bit c for column c
+        int chunkRow;
+        int chunkCol;
+        bool floodPending;              // A flood stopped at empty tiles here (EndlessGame)
+    };
+
+    // What is left of a changed chunk after eviction
+    struct PackedChunk {
+        uint32_t revealed[CHUNK_SIZE];
+        uint32_t flagged[CHUNK_SIZE];
+        bool floodPending;
+    };
+
+    uint64_t seed;
+    uint32_t mineThreshold;     // A tile is mined when its 32 random bits are below this
+    unordered_map<uint64_t, unique_ptr<Chunk>> chunks;      // Chunks in memory, by key
+    unordered_map<uint64_t, PackedChunk> packedChunks;      // Evicted chunks the player had changed
+    unordered_map<uint64_t, uint8_t> clearedChunks;         // Evicted chunks with every safe tile revealed, 1 if every mine was flagged
+    unordered_map<uint64_t, uint64_t> spilledChunks;        // Packed chunks in the spill file: record * 2, +1 if a flood is pending
+    vector<unique_ptr<Chunk>> spareChunks;                  // Evicted chunk storage, reused for new chunks
+    size_t maxPackedChunks = 1 << 16;                       // Packed chunks kept in memory (16 MB) before spilling
+    long long chunksCreated = 0;
+    long long floodPendingChunks = 0;                       // Chunks, in memory or not, with floodPending set
+
+    // Mines are placed independently with the given probability. The 3x3 around the origin never has mines,
+    // so a game can always open there.
+    EndlessBoard(uint64_t boardSeed, double density) {
+        seed = boardSeed;
+        double threshold = density * 4294967296.0;
+        mineThreshold = threshold <= 0 ? 0 : threshold >= 4294967295.0 ? 0xFFFFFFFFu : (uint32_t)threshold;
+    }
+
+    ~EndlessBoard() {
+        if (spillFile) {
+            fclose(spillFile);
+        }
+    }
+
+    EndlessBoard(const EndlessBoard&) = delete;
+    EndlessBoard& operator=(const EndlessBoard&) = delete;
+
+    static uint64_t key(int chunkRow, int chunkCol) {
+        return (uint64_t)(uint32_t)chunkRow << 32 | (uint32_t)chunkCol;
+    }
+
+    Tile& tileAt(int row, int col) {
+        Chunk& chunk = chunkAt(row >> CHUNK_SHIFT, col >> CHUNK_SHIFT);
+        return chunk.tiles[(row & CHUNK_MASK) * CHUNK_SIZE + (col & CHUNK_MASK)];
+    }
+
+    // The tile for drawing. Chunks the player never changed are not created just to be drawn hidden.
+    Tile peekTile(int row, int col) {
+        int chunkRow = row >> CHUNK_SHIFT;
+        int chunkCol = col >> CHUNK_SHIFT;
+        uint64_t chunkKey = key(chunkRow, chunkCol);
+        if (!(cachedChunk && cachedKey == chunkKey) && chunks.find(chunkKey) == chunks.end()
+            && packedChunks.find(chunkKey) == packedChunks.end() && clearedChunks.find(chunkKey) == clearedChunks.end()
+            && spilledChunks.find(chunkKey) == spilledChunks.end()) {
+            return Tile();
+        }
+        return tileAt(row, col);
+    }
+
+    // The chunk holding the given chunk coordinates, created if it is not in memory.
+    Chunk& chunkAt(int chunkRow, int chunkCol) {
+        uint64_t chunkKey = key(chunkRow, chunkCol);
+        // Consecutive lookups are nearly always in the same chunk
+        if (cachedChunk && cachedKey == chunkKey) {
+            return *cachedChunk;
+        }
+        auto found = chunks.find(chunkKey);
+        Chunk* chunk = found != chunks.end() ? found->second.get() : createChunk(chunkRow, chunkCol);
+        cachedKey = chunkKey;
+        cachedChunk = chunk;
+        return *chunk;
+    }
+
+    // Evicts every chunk more than KEEP_RADIUS chunks away from the tile, once fewer than room chunks could be
+    // created without going over MAX_RESIDENT_CHUNKS. Unchanged chunks are dropped and changed ones packed.
+    void evictFarFrom(int row, int col, int room = 0) {
+        if ((int)chunks.size() + room <= MAX_RESIDENT_CHUNKS) {
+            return;
+        }
+        long long focusRow = row >> CHUNK_SHIFT;
+        long long focusCol = col >> CHUNK_SHIFT;
+        for (auto it = chunks.begin(); it != chunks.end();) {
+            Chunk& chunk = *it->second;
+            if (llabs(chunk.chunkRow - focusRow) <= KEEP_RADIUS && llabs(chunk.chunkCol - focusCol) <= KEEP_RADIUS) {
+                ++it;
+                continue;
+            }
+            pack(chunk);
+            spareChunks.push_back(move(it->second));
+            it = chunks.erase(it);
+        }
+        cachedChunk = nullptr;
+    }
+
+    // Drops every chunk, for a new game on the same board object.
+    void clear(uint64_t boardSeed) {
+        seed = boardSeed;
+        for (auto& entry : chunks) {
+            spareChunks.push_back(move(entry.second));
+        }
+        chunks.clear();
+        packedChunks.clear();
+        clearedChunks.clear();
+        spilledChunks.clear();
+        freeSpillRecords.clear();
+        spillRecords = 0;
+        floodPendingChunks = 0;
+        cachedChunk = nullptr;
+    }
+
+    // Marks a flood as stopped in the chunk holding the tile
+    void setFloodPending(int row, int col) {
+        Chunk& chunk = chunkAt(row >> CHUNK_SHIFT, col >> CHUNK_SHIFT);
+        if (!chunk.floodPending) {
+            chunk.floodPending = true;
+            floodPendingChunks++;
+        }
+    }
+
+    // Whether a flood stopped in a chunk, without creating it
+    bool isFloodPending(int chunkRow, int chunkCol) const {
+        uint64_t chunkKey = key(chunkRow, chunkCol);
+        auto resident = chunks.find(chunkKey);
+        if (resident != chunks.end()) {
+            return resident->second->floodPending;
+        }
+        auto packed = packedChunks.find(chunkKey);
+        if (packed != packedChunks.end()) {
+            return packed->second.floodPending;
+        }
+        auto spilled = spilledChunks.find(chunkKey);
+        return spilled != spilledChunks.end() && (spilled->second & 1);
+    }
+
+    // Approximate memory held by the board, including spare chunks and hash table nodes.
+    size_t memoryBytes() const {
+        size_t node = sizeof(void*) * 2 + sizeof(uint64_t);
+        return (chunks.size() + spareChunks.size()) * sizeof(Chunk) + chunks.size() * (node + sizeof(void*))
+             + packedChunks.size() * (node + sizeof(PackedChunk)) + clearedChunks.size() * (node + sizeof(void*))
+             + spilledChunks.size() * (node + sizeof(uint64_t)) + freeSpillRecords.capacity() * sizeof(uint64_t)
+             + (chunks.bucket_count() + packedChunks.bucket_count() + clearedChunks.bucket_count()
+                + spilledChunks.bucket_count()) * sizeof(void*);
+    }
+
+    // The mine bits of a chunk, one 32-bit row per chunk row, from the seed and its coordinates alone.
+    void generateMines(int chunkRow, int chunkCol, uint32_t mines[CHUNK_SIZE]) const {
+        Rng rng(Rng::stream(seed, key(chunkRow, chunkCol)));
+        for (int row = 0; row < CHUNK_SIZE; row++) {
+            uint32_t bits = 0;
+            for (int col = 0; col < CHUNK_SIZE; col += 2) {
+                uint64_t value = rng.next();
+                bits |= (uint32_t)((uint32_t)value < mineThreshold) << col;
+                bits |= (uint32_t)((uint32_t)(value >> 32) < mineThreshold) << (col + 1);
+            }
+            mines[row] = bits;
+        }
+
+        // Keep the opening around the origin safe
+        for (int row = -1; row <= 1; row++) {
+            for (int col = -1; col <= 1; col++) {
+                if (row >> CHUNK_SHIFT == chunkRow && col >> CHUNK_SHIFT == chunkCol) {
+                    mines[row & CHUNK_MASK] &= ~((uint32_t)1 << (col & CHUNK_MASK));
+                }
+            }
+        }
+    }
+
+private:
+    uint64_t cachedKey = 0;
+    Chunk* cachedChunk = nullptr;
+    FILE* spillFile = nullptr;          // Opened when the first chunk is spilled, removed when closed
+    bool spillFailed = false;
+    uint64_t spillRecords = 0;          // Records written to the spill file, in use or free
+    vector<uint64_t> freeSpillRecords;  // Records of chunks that were rebuilt, reused for the next spilled ones
+
+    void mineRowsOf(int chunkRow, int chunkCol, uint32_t mines[CHUNK_SIZE]) const {
+        auto found = chunks.find(key(chunkRow, chunkCol));
+        if (found != chunks.end()) {
+            memcpy(mines, found->second->mines, sizeof(found->second->mines));
+        }
+        else {
+            generateMines(chunkRow, chunkCol, mines);
+        }
+    }
+
+    // Builds a chunk: its mines, its counts from the mines of the eight chunks around it, and the player's
+    // changes if it was packed.
+    Chunk* createChunk(int chunkRow, int chunkCol) {
+        unique_ptr<Chunk> created;
+        if (!spareChunks.empty()) {
+            created = move(spareChunks.back());
+            spareChunks.pop_back();
+        }
+        else {
+            created.reset(new Chunk());
+        }
+        Chunk& chunk = *created;
+        chunk.chunkRow = chunkRow;
+        chunk.chunkCol = chunkCol;
+        chunk.floodPending = false;
+        chunksCreated++;
+
+        // Mine rows of the 3x3 block of chunks centered on this one
+        uint32_t around[3][3][CHUNK_SIZE];
+        for (int blockRow = 0; blockRow < 3; blockRow++) {
+            for (int blockCol = 0; blockCol < 3; blockCol++) {
+                if (blockRow == 1 && blockCol == 1) {
+                    generateMines(chunkRow, chunkCol, around[1][1]);
+                }
+                else {
+                    mineRowsOf(chunkRow + blockRow - 1, chunkCol + blockCol - 1, around[blockRow][blockCol]);
+                }
+            }
+        }
+        memcpy(chunk.mines, around[1][1], sizeof(chunk.mines));
+
+        // Padded rows for the bitboard counter in minecount.h: bit c of the middle word is column c, bit 32 the
+        // first column of the chunk to the right, and bit 63 of the left word the last column to the left.
+        uint64_t middleWords[CHUNK_SIZE + 2];
+        uint64_t leftWords[CHUNK_SIZE + 2];
+        for (int padded = 0; padded < CHUNK_SIZE + 2; padded++) {
+            int row = padded - 1;
+            int blockRow = row < 0 ? 0 : row >= CHUNK_SIZE ? 2 : 1;
+            int localRow = row & CHUNK_MASK;
+            middleWords[padded] = around[blockRow][1][localRow] | (uint64_t)(around[blockRow][2][localRow] & 1) << 32;
+            leftWords[padded] = (uint64_t)(around[blockRow][0][localRow] >> 31) << 63;
+        }
+
+        for (int row = 0; row < CHUNK_SIZE; row++) {
+            Tile* tileRow = &chunk.tiles[row * CHUNK_SIZE];
+            for (int col = 0; col < CHUNK_SIZE; col++) {
+                tileRow[col].bits = (chunk.mines[row] >> col & 1) ? Tile::MINED : 0;
+            }
+            uint64_t up[3] = {leftWords[row], middleWords[row], 0};
+            uint64_t mid[3] = {leftWords[row + 1], middleWords[row + 1], 0};
+            uint64_t down[3] = {leftWords[row + 2], middleWords[row + 2], 0};
+            uint64_t planes[4];
+            addNeighborPlanes(up, mid, down, planes);
+            storeCounts(planes, tileRow, CHUNK_SIZE);
+        }
+
+        auto packed = packedChunks.find(key(chunkRow, chunkCol));
+        if (packed != packedChunks.end()) {
+            unpack(packed->second, chunk);
+            packedChunks.erase(packed);
+        }
+        auto spilled = spilledChunks.find(key(chunkRow, chunkCol));
+        if (spilled != spilledChunks.end()) {
+            uint64_t record = spilled->second >> 1;
+            PackedChunk restored;
+            if (fseek(spillFile, (long)(record * sizeof(PackedChunk)), SEEK_SET) == 0
+                && fread(&restored, sizeof(restored), 1, spillFile) == 1) {
+                unpack(restored, chunk);
+            }
+            else {
+                cout << "Error: a spilled chunk of the endless board cannot be read back." << endl;
+            }
+            freeSpillRecords.push_back(record);
+            spilledChunks.erase(spilled);
+        }
+        auto cleared = clearedChunks.find(key(chunkRow, chunkCol));
+        if (cleared != clearedChunks.end()) {
+            for (Tile& tile : chunk.tiles) {
+                tile.bits |= tile.isMined() ? (cleared->second ? Tile::FLAGGED : 0) : Tile::REVEALED;
+            }
+            clearedChunks.erase(cleared);
+        }
+
+        Chunk* result = created.get();
+        chunks[key(chunkRow, chunkCol)] = move(created);
+        return result;
+    }
+
+    void unpack(const PackedChunk& packed, Chunk& chunk) {
+        for (int row = 0; row < CHUNK_SIZE; row++) {
+            for (int col = 0; col < CHUNK_SIZE; col++) {
+                Tile& tile = chunk.tiles[row * CHUNK_SIZE + col];
+                tile.setRevealed(packed.revealed[row] >> col & 1);
+                tile.setFlagged(packed.flagged[row] >> col & 1);
+            }
+        }
+        chunk.floodPending = packed.floodPending;
+    }
+
+    // Writes a packed chunk to the spill file. Returns false if the file cannot be opened or written, and the
+    // chunk then stays in memory.
+    bool spill(uint64_t chunkKey, const PackedChunk& packed) {
+        if (!spillFile && !spillFailed) {
+            spillFile = tmpfile();
+            spillFailed = !spillFile;
+        }
+        if (!spillFile) {
+            return false;
+        }
+        uint64_t record = spillRecords;
+        if (!freeSpillRecords.empty()) {
+            record = freeSpillRecords.back();
+        }
+        if (fseek(spillFile, (long)(record * sizeof(PackedChunk)), SEEK_SET) != 0
+            || fwrite(&packed, sizeof(packed), 1, spillFile) != 1) {
+            return false;
+        }
+        if (record == spillRecords) {
+            spillRecords++;
+        }
+        else {
+            freeSpillRecords.pop_back();
+        }
+        spilledChunks[chunkKey] = record * 2 + (packed.floodPending ? 1 : 0);
+        return true;
+    }
+
+    // Keeps the player's changes to a chunk that is being evicted. Unchanged chunks leave nothing behind.
+    void pack(const Chunk& chunk) {
+        PackedChunk packed;
+        packed.floodPending = chunk.floodPending;
+        bool changed = false;
+        bool allSafeRevealed = true;
+        bool noFlags = true;
+        bool minesFlagged = true;
+        for (int row = 0; row < CHUNK_SIZE; row++) {
+            uint32_t revealed = 0;
+            uint32_t flagged = 0;
+            for (int col = 0; col < CHUNK_SIZE; col++) {
+                const Tile& tile = chunk.tiles[row * CHUNK_SIZE + col];
+                revealed |= (uint32_t)tile.isRevealed() << col;
+                flagged |= (uint32_t)tile.isFlagged() << col;
+            }
+            packed.revealed[row] = revealed;
+            packed.flagged[row] = flagged;
+            changed = changed || revealed || flagged;
+            allSafeRevealed = allSafeRevealed && revealed == ~chunk.mines[row];
+            noFlags = noFlags && flagged == 0;
+            minesFlagged = minesFlagged && flagged == chunk.mines[row];
+        }
+        if (!changed) {
+            return;
+        }
+        uint64_t chunkKey = key(chunk.chunkRow, chunk.chunkCol);
+        // A pending flood can continue into the next chunk even when this one is cleared, so it keeps the bits
+        if (allSafeRevealed && (noFlags || minesFlagged) && !chunk.floodPending) {
+            clearedChunks[chunkKey] = noFlags ? 0 : 1;
+        }
+        else if (packedChunks.size() < maxPackedChunks || !spill(chunkKey, packed)) {
+            packedChunks[chunkKey] = packed;
+        }
+    }
+};
+
+// The rules of endless mode. Like Game, but there is no win: the score is the number of tiles revealed,
+// and the game ends on the first mine. At low mine densities an opening can be unbounded, so a reveal only
+// floods up to FLOOD_RADIUS tiles from the clicked tile. The chunks where it stopped are marked, and the
+// flood continues from their empty tiles with hidden neighbors as soon as the player reveals or chords near
+// them. So a revealed empty tile with hidden neighbors only exists FLOOD_RADIUS or more tiles from where the
+// player last acted, well outside the view. The mark is kept with the chunk, packed or spilled when it is
+// evicted, so it costs no memory of its own.
+// Everything an action touches lies within FLOOD_CHUNK_RADIUS chunks of the focus, inside the chunks eviction
+// keeps, and chunks are evicted before each action if that many could take the board over its resident cap.
+class EndlessGame {
+public:
+    static const int FLOOD_RADIUS = 128;
+    static const int FLOOD_CHUNK_RADIUS = (FLOOD_RADIUS >> EndlessBoard::CHUNK_SHIFT) + 1;
+    static const int ACTION_CHUNKS = (2 * FLOOD_CHUNK_RADIUS + 1) * (2 * FLOOD_CHUNK_RADIUS + 1);
+    static_assert(FLOOD_CHUNK_RADIUS <= EndlessBoard::KEEP_RADIUS, "a flood must not reach chunks eviction drops");
+    static_assert((2 * EndlessBoard::KEEP_RADIUS + 1) * (2 * EndlessBoard::KEEP_RADIUS + 1)
+                      <= EndlessBoard::MAX_RESIDENT_CHUNKS, "the kept chunks must fit in the resident cap");
+
+    EndlessBoard board;
+    vector<Cell> worklist;      // Empty tiles whose neighbors still have to be revealed
+    vector<Cell> revealed;      // The tiles revealed by the last call
+    vector<Cell> changedTiles;  // Tiles changed since a view last took the changes
+    bool trackChanges = true;
+    bool gameLost = false;
+    Cell lostCell = {0, 0};
+    Cell focus = {0, 0};        // The last tile the player acted on. Chunks far from it are evicted.
+    long long tilesRevealed = 0;
+    long long flagsPlaced = 0;
+
+    EndlessGame(double density, uint64_t gameSeed = newSeed()) : board(gameSeed, density) {
+    }
+
+    uint64_t seed() const {
+        return board.seed;
+    }
+
+    // Reveals a hidden tile, flooding the opening around it if it has no adjacent mines.
+    const vector<Cell>& reveal(int row, int col) {
+        revealed.clear();
+        if (gameLost) {
+            return revealed;
+        }
+        board.evictFarFrom(row, col, ACTION_CHUNKS);
+        focus = {row, col};
+        revealTile(row, col);
+        resumeFlood();
+        expand();
+        return revealed;
+    }
+
+    // Reveals every unflagged neighbor of a revealed number once it has that many flags around it.
+    const vector<Cell>& chord(int row, int col) {
+        revealed.clear();
+        if (gameLost) {
+            return revealed;
+        }
+        board.evictFarFrom(row, col, ACTION_CHUNKS);
+        const Tile& tile = board.tileAt(row, col);
+        if (!tile.isRevealed() || tile.adjacentMineCount() == 0) {
+            return revealed;
+        }
+        int flags = 0;
+        for (int i = 0; i < 8; i++) {
+            flags += board.tileAt(row + rowOffsets[i], col + colOffsets[i]).isFlagged();
+        }
+        if (flags != tile.adjacentMineCount()) {
+            return revealed;
+        }
+        focus = {row, col};
+        for (int i = 0; i < 8 && !gameLost; i++) {
+            revealTile(row + rowOffsets[i], col + colOffsets[i]);
+        }
+        resumeFlood();
+        expand();
+        return revealed;
+    }
+
+    // Places or removes a flag on a hidden tile. Returns false if nothing changed.
+    bool toggleFlag(int row, int col) {
+        if (gameLost) {
+            return false;
+        }
+        board.evictFarFrom(row, col, ACTION_CHUNKS);
+        Tile& tile = board.tileAt(row, col);
+        if (tile.isRevealed()) {
+            return false;
+        }
+        focus = {row, col};
+        tile.setFlagged(!tile.isFlagged());
+        flagsPlaced += tile.isFlagged() ? 1 : -1;
+        if (trackChanges) {
+            changedTiles.push_back({row, col});
+        }
+        return true;
+    }
+
+    // Called by a view once it has redrawn the changed tiles
+    void clearChanges() {
+        changedTiles.clear();
+    }
+
+    // Starts a new endless game, reusing the chunk storage.
+    void reset(uint64_t gameSeed = newSeed()) {
+        board.clear(gameSeed);
+        worklist.clear();
+        revealed.clear();
+        changedTiles.clear();
+        gameLost = false;
+        lostCell = {0, 0};
+        focus = {0, 0};
+        tilesRevealed = 0;
+        flagsPlaced = 0;
+    }
+
+private:
+    const int rowOffsets[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+    const int colOffsets[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+
+    void revealTile(int row, int col) {
+        Tile& tile = board.tileAt(row, col);
+        if (tile.isFlagged() || tile.isRevealed()) {
+            return;
+        }
+        if (tile.isMined()) {
+            tile.setRevealed(true);
+            gameLost = true;
+            lostCell = {row, col};
+            if (trackChanges) {
+                changedTiles.push_back(lostCell);
+            }
+            return;
+        }
+        visit(tile, row, col);
+    }
+
+    void visit(Tile& tile, int row, int col) {
+        tile.setRevealed(true);
+        tilesRevealed++;
+        revealed.push_back({row, col});
+        if (tile.adjacentMineCount() == 0) {
+            worklist.push_back({row, col});
+        }
+    }
+
+    // Queues the empty tiles with hidden neighbors in the chunks around the focus where a flood stopped.
+    // Those still out of reach mark their chunk again in expand.
+    void resumeFlood() {
+        if (gameLost || board.floodPendingChunks == 0) {
+            return;
+        }
+        int focusChunkRow = focus.row >> EndlessBoard::CHUNK_SHIFT;
+        int focusChunkCol = focus.col >> EndlessBoard::CHUNK_SHIFT;
+        for (int chunkRow = focusChunkRow - FLOOD_CHUNK_RADIUS; chunkRow <= focusChunkRow + FLOOD_CHUNK_RADIUS;
+             chunkRow++) {
+            for (int chunkCol = focusChunkCol - FLOOD_CHUNK_RADIUS; chunkCol <= focusChunkCol + FLOOD_CHUNK_RADIUS;
+                 chunkCol++) {
+                if (!board.isFloodPending(chunkRow, chunkCol)) {
+                    continue;
+                }
+                EndlessBoard::Chunk& chunk = board.chunkAt(chunkRow, chunkCol);
+                chunk.floodPending = false;
+                board.floodPendingChunks--;
+                queueOpenEdges(chunk);
+            }
+        }
+    }
+
+    // Queues the revealed empty tiles of a chunk that have a neighbor left to reveal
+    void queueOpenEdges(const EndlessBoard::Chunk& chunk) {
+        for (int localRow = 0; localRow < EndlessBoard::CHUNK_SIZE; localRow++) {
+            for (int localCol = 0; localCol < EndlessBoard::CHUNK_SIZE; localCol++) {
+                const Tile& tile = chunk.tiles[localRow * EndlessBoard::CHUNK_SIZE + localCol];
+                if (!tile.isRevealed() || tile.isMined() || tile.adjacentMineCount() != 0) {
+                    continue;
+                }
+                int row = chunk.chunkRow * EndlessBoard::CHUNK_SIZE + localRow;
+                int col = chunk.chunkCol * EndlessBoard::CHUNK_SIZE + localCol;
+                for (int i = 0; i < 8; i++) {
+                    const Tile& neighbor = board.tileAt(row + rowOffsets[i], col + colOffsets[i]);
+                    if (!(neighbor.bits & (Tile::REVEALED | Tile::FLAGGED))) {
+                        worklist.push_back({row, col});
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    // Reveals the neighbors of queued empty tiles across chunk edges, up to FLOOD_RADIUS from the focus.
+    // Empty tiles with neighbors out of reach mark their chunk. Neighbors of an empty tile are never mined.
+    void expand() {
+        while (!worklist.empty()) {
+            Cell current = worklist.back();
+            worklist.pop_back();
+            bool stopped = false;
+            for (int i = 0; i < 8; i++) {
+                int row = current.row + rowOffsets[i];
+                int col = current.col + colOffsets[i];
+                if (llabs((long long)row - focus.row) > FLOOD_RADIUS || llabs((long long)col - focus.col) > FLOOD_RADIUS) {
+                    stopped = true;
+                    continue;
+                }
+                Tile& neighbor = board.tileAt(row, col);
+                if (!(neighbor.bits & (Tile::REVEALED | Tile::FLAGGED))) {
+                    visit(neighbor, row, col);
+                }
+            }
+            if (stopped) {
+                board.setFloodPending(current.row, current.col);
+            }
+        }
+        if (trackChanges) {
+            changedTiles.insert(changedTiles.end(), revealed.begin(), revealed.end());
+        }
+    }
+};
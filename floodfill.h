@@ -0,0 +1,67 @@
+#pragma once
+#include "board.h"
+#include <vector>
+
+using namespace std;
+
+// Reveals the opening around a clicked tile without recursion.
+// Tiles are marked revealed as soon as they are queued, so each tile is visited once,
+// and both buffers keep their capacity between clicks so later clicks do not allocate.
+class FloodFill {
+public:
+    vector<int> worklist;   // Empty tiles whose neighbors still have to be revealed
+    vector<int> revealed;   // The batch of tile indices revealed by the last call
+
+    FloodFill() = default;
+
+    // Preallocate the buffers for a board of the given size
+    explicit FloodFill(size_t tiles) {
+        size_t initial = tiles < 65536 ? tiles : 65536;
+        worklist.reserve(initial);
+        revealed.reserve(initial);
+    }
+
+    // Reveals the tile at index and, if it has no adjacent mines, every tile reachable through empty tiles.
+    // Returns the batch of revealed tile indices. Mined, flagged or already revealed tiles reveal nothing.
+    const vector<int>& reveal(Board& board, int index) {
+        revealed.clear();
+        return revealMore(board, index);
+    }
+
+    // Same as reveal, but adds to the current batch instead of starting a new one (used for chords).
+    const vector<int>& revealMore(Board& board, int index) {
+        worklist.clear();
+        size_t batchStart = revealed.size();
+
+        if (board.tiles[index].bits & (Tile::MINED | Tile::REVEALED | Tile::FLAGGED)) {
+            return revealed;
+        }
+        visit(board, index);
+
+        while (!worklist.empty()) {
+            int current = worklist.back();
+            worklist.pop_back();
+
+            // Neighbors of an empty tile are never mined. Border tiles count as revealed.
+            for (int offset : board.neighborOffsets) {
+                int neighbor = current + offset;
+                if (!(board.tiles[neighbor].bits & (Tile::REVEALED | Tile::FLAGGED))) {
+                    visit(board, neighbor);
+                }
+            }
+        }
+
+        board.nonMinesRevealed += (int)(revealed.size() - batchStart);
+        return revealed;
+    }
+
+private:
+    void visit(Board& board, int index) {
+        Tile& tile = board.tiles[index];
+        tile.setRevealed(true);
+        revealed.push_back(index);
+        if (tile.adjacentMineCount() == 0) {
+            worklist.push_back(index);
+        }
+    }
+};
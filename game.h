@@ -0,0 +1,258 @@
+#pragma once
+#include "board.h"
+#include "floodfill.h"
+#include "noguess.h"
+#include "rng.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// The rules of Minesweeper, addressed by (row, col) and independent of any window or rendering,
+// so bots and simulations can play without SFML. The screens are a view on top of this class.
+// Mines are placed from the game's seed on the first reveal, so the first click is never a mine
+// and the same seed and first click always give the same board.
+class Game {
+public:
+    Board board;
+    FloodFill floodFill;    // Reveal engine; its batch holds the tiles revealed by the last action
+    uint64_t seed;          // Seed of the current game
+    bool safeNeighborhood = false;  // Keep the whole 3x3 around the first click free of mines, not just the tile
+    bool noGuess = false;           // Place the mines so the board can be solved from the first click (noguess.h)
+    NoGuessGenerator noGuessGenerator;  // Places them when noGuess is set; its counters describe the last board
+    bool gameLost = false;
+    bool gameWon = false;
+    int flagCounter;        // Mines minus flags placed, as shown on the mine counter
+    int lostIndex = -1;     // Index of the mine that ended the game, if any
+
+    // Tiles whose appearance changed since a view last took the changes, so it can redraw only those.
+    vector<int> changedTiles;
+    bool boardChanged = true;   // Every tile changed (new game), views should redraw the whole board
+    bool trackChanges = true;   // Headless players without a view can turn the change list off
+
+    // Tiles changed since the last snapshot was taken (snapshot.h), kept only while snapshots are taken.
+    vector<int> journal;
+    bool journalAll = false;    // Every tile changed (new game or mines placed)
+    bool keepJournal = false;
+
+    Game(int rows, int cols, int mines, uint64_t gameSeed = newSeed()) : board(rows, cols, mines), floodFill((size_t)rows * cols) {
+        seed = gameSeed;
+        flagCounter = board._mines;
+    }
+
+    int rows() const {
+        return board._rows;
+    }
+
+    int cols() const {
+        return board._cols;
+    }
+
+    int mines() const {
+        return board._mines;
+    }
+
+    bool isOver() const {
+        return gameLost || gameWon;
+    }
+
+    bool inBounds(int row, int col) const {
+        return row >= 0 && row < board._rows && col >= 0 && col < board._cols;
+    }
+
+    const Tile& tileAt(int row, int col) const {
+        return board.tileAt(row, col);
+    }
+
+    // Tiles revealed by the last reveal or chord
+    const vector<int>& lastRevealed() const {
+        return floodFill.revealed;
+    }
+
+    // Called by a view once it has redrawn the changed tiles
+    void clearChanges() {
+        changedTiles.clear();
+        boardChanged = false;
+    }
+
+    // Reveals a hidden tile, flooding the opening around it if it has no adjacent mines.
+    // Returns the batch of revealed tile indices, which is empty if nothing changed.
+    const vector<int>& reveal(int row, int col) {
+        floodFill.revealed.clear();
+        if (isOver() || !inBounds(row, col)) {
+            return floodFill.revealed;
+        }
+
+        // A flagged tile cannot be revealed, so clicking one does not spend the safe first click
+        if (board.tileAt(row, col).isFlagged()) {
+            return floodFill.revealed;
+        }
+        if (!board.minesPlaced) {
+            placeMines(row, col);
+        }
+        revealIndex(board.index(row, col));
+        recordRevealed();
+        checkForEndGame();
+        return floodFill.revealed;
+    }
+
+    // Places the mines around a safe tile without revealing it. Reveal does this on the first click.
+    void placeMines(int safeRow, int safeCol) {
+        if (noGuess) {
+            noGuessGenerator.generate(board, seed, safeRow, safeCol);
+        }
+        else {
+            board.placeMines(seed, safeRow, safeCol, safeNeighborhood);
+        }
+
+        // Flags placed before the mines existed may turn out to be on mines
+        board.minesFlagged = 0;
+        for (int index : board.mineIndices) {
+            board.minesFlagged += board.tiles[index].isFlagged();
+        }
+        boardChanged = true;
+        journalAll = true;
+    }
+
+    // Reveals every unflagged neighbor of a revealed number once it has that many flags around it.
+    // Returns the batch of revealed tile indices.
+    const vector<int>& chord(int row, int col) {
+        floodFill.revealed.clear();
+        if (isOver() || !inBounds(row, col)) {
+            return floodFill.revealed;
+        }
+
+        int index = board.index(row, col);
+        const Tile& tile = board.tiles[index];
+        if (!tile.isRevealed() || tile.adjacentMineCount() == 0) {
+            return floodFill.revealed;
+        }
+
+        int flags = 0;
+        for (int offset : board.neighborOffsets) {
+            flags += board.tiles[index + offset].isFlagged();
+        }
+        if (flags != tile.adjacentMineCount()) {
+            return floodFill.revealed;
+        }
+
+        for (int offset : board.neighborOffsets) {
+            revealIndex(index + offset);
+        }
+        recordRevealed();
+        checkForEndGame();
+        return floodFill.revealed;
+    }
+
+    // Flags or unflags a hidden tile. Returns true if the tile changed.
+    bool toggleFlag(int row, int col) {
+        if (isOver() || !inBounds(row, col)) {
+            return false;
+        }
+
+        Tile& tile = board.tileAt(row, col);
+        if (tile.isRevealed()) {
+            return false;
+        }
+
+        if (!tile.isFlagged()) {
+            tile.setFlagged(true);
+            flagCounter--;
+            if (tile.isMined()) {
+                board.minesFlagged++;
+            }
+        }
+        else {
+            tile.setFlagged(false);
+            flagCounter++;
+            if (tile.isMined()) {
+                board.minesFlagged--;
+            }
+        }
+        tileChanged(board.index(row, col));
+        return true;
+    }
+
+    // Starts a new game on an empty board of the same size. Mines are placed on the first reveal.
+    // The board and every buffer are reused in place, so once a game has been played resets do not allocate.
+    void reset(uint64_t gameSeed = newSeed()) {
+        seed = gameSeed;
+        board.clearMines(board._mines);
+        floodFill.revealed.clear();
+        gameLost = false;
+        gameWon = false;
+        flagCounter = board._mines;
+        lostIndex = -1;
+        changedTiles.clear();
+        boardChanged = true;
+        journal.clear();
+        journalAll = true;
+        // Room for every tile to be revealed, so the lists do not grow during later games
+        size_t tiles = (size_t)board._rows * board._cols;
+        if (trackChanges) {
+            changedTiles.reserve(tiles);
+        }
+        if (keepJournal) {
+            journal.reserve(tiles);
+        }
+    }
+
+private:
+    void revealIndex(int index) {
+        Tile& tile = board.tiles[index];
+        if (tile.isFlagged() || tile.isRevealed()) {
+            return;
+        }
+
+        // End the game if a mine was revealed.
+        if (tile.isMined()) {
+            tile.setRevealed(true);
+            gameLost = true;
+            lostIndex = index;
+            if (trackChanges) {
+                changedTiles.insert(changedTiles.end(), board.mineIndices.begin(), board.mineIndices.end());
+            }
+            if (keepJournal) {
+                journal.push_back(index);
+            }
+            return;
+        }
+
+        floodFill.revealMore(board, index);
+    }
+
+    void recordRevealed() {
+        if (trackChanges) {
+            changedTiles.insert(changedTiles.end(), floodFill.revealed.begin(), floodFill.revealed.end());
+        }
+        if (keepJournal) {
+            journal.insert(journal.end(), floodFill.revealed.begin(), floodFill.revealed.end());
+        }
+    }
+
+    void tileChanged(int index) {
+        if (trackChanges) {
+            changedTiles.push_back(index);
+        }
+        if (keepJournal) {
+            journal.push_back(index);
+        }
+    }
+
+    // The game is won once every tile without a mine has been revealed. Every mine is then flagged.
+    void checkForEndGame() {
+        if (gameLost || board.nonMinesRevealed != board._rows * board._cols - board._mines) {
+            return;
+        }
+
+        gameWon = true;
+        for (int index : board.mineIndices) {
+            Tile& tile = board.tiles[index];
+            if (!tile.isFlagged()) {
+                tile.setFlagged(true);
+                board.minesFlagged++;
+                tileChanged(index);
+            }
+        }
+    }
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include "textures.h"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+// A fixed row of digits from the digits strip, with a minus sign in front for negative values, as used by the
+// timer and the mine counter. The sprites are placed once and only their texture rects change, and only when
+// the shown value does, so calling show every frame costs a comparison and never allocates.
+class DigitDisplay {
+public:
+    static const int MAX_DIGITS = 3;
+
+    sf::Sprite digits[MAX_DIGITS];
+    sf::Sprite minusSign;           // Drawn one digit to the left of the digits
+    int digitCount = 0;
+    int value = 0;                  // The value shown
+    const Textures* textures = nullptr;
+
+    // Places count digits left to right from (x, y) and shows 0.
+    void setup(const Textures& atlas, int count, float x, float y) {
+        textures = &atlas;
+        digitCount = min(count, MAX_DIGITS);
+        for (int i = 0; i < digitCount; i++) {
+            digits[i].setPosition(x + (float)(i * Textures::DIGIT_WIDTH), y);
+        }
+        atlas.applyDigit(minusSign, 10);
+        minusSign.setPosition(x - (float)Textures::DIGIT_WIDTH, y);
+        setDigits(0);
+    }
+
+    // Shows the last digits of a value.
+    void show(int newValue) {
+        if (newValue != value) {
+            setDigits(newValue);
+        }
+    }
+
+    void draw(sf::RenderTarget& target) const {
+        if (value < 0) {
+            target.draw(minusSign);
+        }
+        for (int i = 0; i < digitCount; i++) {
+            target.draw(digits[i]);
+        }
+    }
+
+private:
+    void setDigits(int newValue) {
+        value = newValue;
+        int remaining = abs(newValue);
+        for (int i = digitCount - 1; i >= 0; i--) {
+            textures->applyDigit(digits[i], remaining % 10);
+            remaining /= 10;
+        }
+    }
+};
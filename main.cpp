@@ -1,6 +1,10 @@
+#include "cputime.h"
 #include "screens.h"
 #include "textures.h"
 #include "leaderboard.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <fstream>
@@ -9,7 +13,14 @@
 using namespace std;
 
 int main() {
+    // Time to first frame runs from here to the first frame shown
+    uint64_t startupBegin = tracer().now();
     Textures textures;
+    tracer().record("load_assets", startupBegin, tracer().now());
+    if (!textures.loaded) {
+        cout << "The game cannot start without its images and font." << endl;
+        return 1;
+    }
 
     // Determine size of the window through config file data
     ifstream infile("files/config.cfg");
@@ -24,31 +35,82 @@ int main() {
     int numRows = stoi(line);
     getline(infile, line);
     int numMines = stoi(line);
+    // An optional fourth line caps the frame rate. Frames are only drawn when something changed either way.
+    unsigned int frameLimit = 0;
+    if (getline(infile, line) && !line.empty()) {
+        frameLimit = (unsigned int)stoi(line);
+    }
+    // An optional fifth line of 1 places the mines so every game can be won without guessing
+    bool noGuess = getline(infile, line) && !line.empty() && stoi(line) != 0;
+    // The window fits the board if the screen has room for it. Larger boards scroll inside the window.
     int width = numColumns * 32;
     int height = (numRows * 32) + 100;
+    sf::VideoMode desktop = sf::VideoMode::getDesktopMode();
+    if (desktop.width > 0 && desktop.height > 0) {
+        width = min(width, (int)desktop.width * 9 / 10);
+        height = min(height, (int)desktop.height * 9 / 10);
+    }
 
     // Main window
     sf::RenderWindow window(sf::VideoMode(width, height), "Minesweeper", sf::Style::Close);
 
     // Create the welcome screen
-    WelcomeScreen welcomeScreen(window, width, height);
+    WelcomeScreen welcomeScreen(window, width, height, textures);
 
     // Create game screen
-    GameScreen gameScreen(window, width, height, numRows, numColumns, numMines, textures.textures);
+    GameScreen gameScreen(window, width, height, numRows, numColumns, numMines, textures, noGuess);
+    cout << "Board state: " << gameScreen.game.board.bytesPerCell() << " bytes per cell." << endl;
 
     // Create leaderboard screen
-    int leaderWidth = (numColumns * 16);
-    int leaderHeight = (numRows * 16) + 50;
+    int leaderWidth = width / 2;
+    int leaderHeight = (height - 100) / 2 + 50;
     sf::RenderWindow leaderboardWindow(sf::VideoMode(leaderWidth, leaderHeight), "Leaderboard", sf::Style::Close);
     Leaderboard leaderboard(window, leaderWidth, leaderHeight);
     leaderboardWindow.setVisible(false);
+    window.setFramerateLimit(frameLimit);
+    leaderboardWindow.setFramerateLimit(frameLimit);
+
+    // Waits for the next event of the main window. While nothing on screen can change by itself this blocks,
+    // so idle screens use no CPU. While the timer runs, the leaderboard window is open or a won game's result is
+    // being saved, it polls every few milliseconds instead, since SFML cannot wait for an event with a timeout.
+    // Returns false if no event came, and sets timerTick once the timer shows a new second.
+    const int POLL_MILLISECONDS = 10;
+    auto waitForWork = [&](sf::Event& event, bool& timerTick) {
+        bool timerRunning = gameScreen.active && gameScreen.timerRunning();
+        bool savingResult = gameScreen.game.gameWon && !gameScreen.leaderboardShownAtEndGame && !leaderboard.active;
+        if (!timerRunning && !savingResult && !leaderboard.active) {
+            return window.waitEvent(event);
+        }
+        int wait = timerRunning ? gameScreen.millisecondsToNextTick() : POLL_MILLISECONDS;
+        auto deadline = chrono::steady_clock::now() + chrono::milliseconds(wait);
+        while (!window.pollEvent(event)) {
+            auto now = chrono::steady_clock::now();
+            if (now >= deadline) {
+                timerTick = timerRunning;
+                return false;
+            }
+            auto remaining = chrono::duration_cast<chrono::milliseconds>(deadline - now).count();
+            sf::sleep(sf::milliseconds((sf::Int32)min<long long>(remaining + 1, POLL_MILLISECONDS)));
+        }
+        return true;
+    };
+
+    bool needsRedraw = true;
+    bool leaderboardNeedsRedraw = true;
+    long long framesDrawn = 0;
+    double cpuStart = processCpuSeconds();
+    auto wallStart = chrono::steady_clock::now();
 
     // Main Game Loop
     while(window.isOpen()) {
 
         // Event Checker
         sf::Event event;
-        while(window.pollEvent(event)) {
+        bool timerTick = false;
+        bool hasEvent = waitForWork(event, timerTick);
+        needsRedraw = needsRedraw || timerTick;
+        uint64_t eventsStart = tracer().now();
+        for (; hasEvent; hasEvent = window.pollEvent(event)) {
             // Exits the program when the 'X' is clicked.
             if(event.type == sf::Event::Closed && !leaderboard.active) {
                 window.close();
@@ -99,6 +161,10 @@ int main() {
                     else if (gameScreen.debugButton.getGlobalBounds().contains((float)mouseX, (float)mouseY)) {
                         gameScreen.toggleDebugMode();
                     }
+                    // Left-clicks on the trace button toggle the frame rate and latency overlay.
+                    else if (gameScreen.traceButton.getGlobalBounds().contains((float)mouseX, (float)mouseY)) {
+                        gameScreen.toggleTrace();
+                    }
                     // Left-clicks on the pause button when the game is active but paused will unpause the game.
                     else if (!gameScreen.isNewGame && gameScreen.isPaused && gameScreen.pauseButton.getGlobalBounds().contains((float)mouseX, (float)mouseY)) {
                         gameScreen.togglePause();
@@ -119,10 +185,50 @@ int main() {
                         // Show the leaderboard window
                         leaderboard.active = true;
                         leaderboardWindow.setVisible(true);
+                        leaderboardNeedsRedraw = true;
                     }
-                    else {
-                        // Left-clicks on the board
-                        gameScreen.leftClickAction(mouseX, mouseY);
+                    // Left presses on the board either click a tile or start dragging the board
+                    else if (gameScreen.camera.contains(mouseX, mouseY)) {
+                        gameScreen.camera.press(mouseX, mouseY);
+                    }
+                }
+                // Left-clicks on the board act when released without dragging, at the pressed position
+                else if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left) {
+                    if (gameScreen.camera.pressed && !gameScreen.camera.release()) {
+                        gameScreen.leftClickAction(gameScreen.camera.pressPosition.x, gameScreen.camera.pressPosition.y);
+                    }
+                }
+                else if (event.type == sf::Event::MouseMoved) {
+                    gameScreen.camera.moveTo(event.mouseMove.x, event.mouseMove.y);
+                }
+                // The mouse wheel zooms around the pointer
+                else if (event.type == sf::Event::MouseWheelScrolled && event.mouseWheelScroll.wheel == sf::Mouse::VerticalWheel) {
+                    if (gameScreen.camera.contains(event.mouseWheelScroll.x, event.mouseWheelScroll.y)) {
+                        gameScreen.camera.zoomAt(event.mouseWheelScroll.delta, event.mouseWheelScroll.x, event.mouseWheelScroll.y);
+                    }
+                }
+                // Arrow keys or WASD pan the board, + and - zoom around its center
+                else if (event.type == sf::Event::KeyPressed) {
+                    Camera& camera = gameScreen.camera;
+                    sf::Keyboard::Key key = event.key.code;
+                    float step = (float)Camera::PAN_STEP;
+                    if (key == sf::Keyboard::Left || key == sf::Keyboard::A) {
+                        camera.pan(-step, 0);
+                    }
+                    else if (key == sf::Keyboard::Right || key == sf::Keyboard::D) {
+                        camera.pan(step, 0);
+                    }
+                    else if (key == sf::Keyboard::Up || key == sf::Keyboard::W) {
+                        camera.pan(0, -step);
+                    }
+                    else if (key == sf::Keyboard::Down || key == sf::Keyboard::S) {
+                        camera.pan(0, step);
+                    }
+                    else if (key == sf::Keyboard::Add || key == sf::Keyboard::Equal) {
+                        camera.zoomAt(1, camera.areaWidth / 2, camera.areaHeight / 2);
+                    }
+                    else if (key == sf::Keyboard::Subtract || key == sf::Keyboard::Hyphen) {
+                        camera.zoomAt(-1, camera.areaWidth / 2, camera.areaHeight / 2);
                     }
                 }
                 // Right-clicks
@@ -130,32 +236,65 @@ int main() {
                     // If the user right-clicks a hidden tile, flag it.
                     gameScreen.rightClickAction(event.mouseButton.x, event.mouseButton.y);
                 }
-
-                // If the game has been won after clicking, switch to the leaderboard
-                if (gameScreen.gameWon && !gameScreen.leaderboardShownAtEndGame) {
-                    leaderboard.resetLeaderboard(gameScreen.newRank);
-                    leaderboard.active = true;
-                    leaderboardWindow.setVisible(true);
+                // Middle-clicks on a number reveal its neighbors once it has enough flags around it.
+                else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Middle) {
+                    gameScreen.middleClickAction(event.mouseButton.x, event.mouseButton.y);
                 }
             }
+
+            // Moving the mouse only changes the screen while it drags the board
+            if (event.type != sf::Event::MouseMoved || gameScreen.camera.dragging) {
+                needsRedraw = true;
+            }
+            // Clicks are timed until the frame that shows them
+            if (event.type == sf::Event::MouseButtonPressed || event.type == sf::Event::MouseButtonReleased) {
+                tracer().markInput();
+            }
         }
+        tracer().record("handle_events", eventsStart, tracer().now());
 
-        // Draw welcome screen
-        window.clear();
-        if (welcomeScreen.active) {
-            welcomeScreen.drawToScreen(window);
+        // Once the game has been won and its result is saved, switch to the leaderboard.
+        // The leaderboard file is written off the UI thread, so this waits for it without blocking a frame.
+        if (gameScreen.active && !leaderboard.active && gameScreen.game.gameWon && !gameScreen.leaderboardShownAtEndGame
+            && gameScreen.scoreStore.idle()) {
+            leaderboard.resetLeaderboard(gameScreen.newRank);
+            leaderboard.active = true;
+            leaderboardWindow.setVisible(true);
+            leaderboardNeedsRedraw = true;
         }
 
-        // Draw game screen
-        if (gameScreen.active) {
-            gameScreen.drawToScreen(window);
+        if (needsRedraw) {
+            TraceScope frameScope("frame");
+            needsRedraw = false;
+            framesDrawn++;
+
+            // Draw welcome screen
+            window.clear();
+            if (welcomeScreen.active) {
+                welcomeScreen.drawToScreen(window);
+            }
+
+            // Draw game screen
+            if (gameScreen.active) {
+                gameScreen.drawToScreen(window);
+            }
+            uint64_t displayStart = tracer().now();
+            window.display();
+            tracer().record("display", displayStart, tracer().now());
+            tracer().markPresent();
+            if (framesDrawn == 1) {
+                tracer().record("time_to_first_frame", startupBegin, tracer().now());
+                cout << "First frame shown " << (tracer().now() - startupBegin) / 1e6 << " ms after start." << endl;
+            }
         }
-        window.display();
 
         sf::Event leaderboardEvent;
         while(leaderboardWindow.pollEvent(leaderboardEvent)) {
+            leaderboardNeedsRedraw = true;
+
             // Exits the program when the 'X' is clicked.
             if (leaderboardEvent.type == sf::Event::Closed) {
+                needsRedraw = true;
                 leaderboardWindow.setVisible(false);
                 leaderboard.active = false;
 
@@ -165,7 +304,7 @@ int main() {
                     gameScreen.unpause();
                 }
                 // If the game was won on the last click, then
-                else if (gameScreen.gameWon) {
+                else if (gameScreen.game.gameWon) {
                     leaderboardWindow.setVisible(false);
                     leaderboard.active = false;
                     gameScreen.leaderboardShownAtEndGame = true;
@@ -173,7 +312,9 @@ int main() {
             }
         }
 
-        if (leaderboard.active) {
+        if (leaderboard.active && leaderboardNeedsRedraw) {
+            TraceScope leaderboardScope("leaderboard_frame");
+            leaderboardNeedsRedraw = false;
             leaderboardWindow.clear();
             leaderboard.drawToScreen(leaderboardWindow);
             leaderboardWindow.display();
@@ -181,5 +322,17 @@ int main() {
 
     }
 
+    // How busy the loop kept the processor, to check that idle screens cost nothing
+    double cpuSeconds = processCpuSeconds() - cpuStart;
+    double wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - wallStart).count();
+    cout << "Drew " << framesDrawn << " frames in " << wallSeconds << " s using " << cpuSeconds << " s of CPU time ("
+         << (wallSeconds > 0 ? 100 * cpuSeconds / wallSeconds : 0) << "%)." << endl;
+
+    // Where the time of the last frames and clicks went. The trace opens in chrome://tracing or ui.perfetto.dev.
+    cout << "Frame and input timings:" << endl << tracer().summary();
+    if (!tracer().writeChromeTrace("files/trace.json")) {
+        cout << "Trace file failed to open." << endl;
+    }
+
     return 0;
 }
\ No newline at end of file
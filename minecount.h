@@ -0,0 +1,171 @@
+#pragma once
+#include "tile.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Word-parallel adjacent mine counting.
+// The mine layout is kept as one bitmask per row, padded with an empty row above and below and an empty
+// word on either side, so every word has all its neighbors. The eight neighbor bit planes of 64 tiles are
+// added at once with bit-sliced adders into four bit planes holding the count of each tile.
+
+// Words per padded bitmask row for a board with the given number of columns
+inline int mineRowWords(int cols) {
+    return (cols + 63) / 64 + 2;
+}
+
+// Adds the eight neighbor planes of one word into the four bit planes of the counts.
+// up, mid and down hold the word and its left and right neighbor words for the rows above, at and below.
+inline void addNeighborPlanes(const uint64_t up[3], const uint64_t mid[3], const uint64_t down[3], uint64_t planes[4]) {
+    uint64_t upLeft = (up[1] << 1) | (up[0] >> 63);
+    uint64_t upRight = (up[1] >> 1) | (up[2] << 63);
+    uint64_t midLeft = (mid[1] << 1) | (mid[0] >> 63);
+    uint64_t midRight = (mid[1] >> 1) | (mid[2] << 63);
+    uint64_t downLeft = (down[1] << 1) | (down[0] >> 63);
+    uint64_t downRight = (down[1] >> 1) | (down[2] << 63);
+
+    // Each row of three (two for the middle row) gives a two-bit sum
+    uint64_t upOnes = upLeft ^ up[1] ^ upRight;
+    uint64_t upTwos = (upLeft & up[1]) | (upRight & (upLeft ^ up[1]));
+    uint64_t downOnes = downLeft ^ down[1] ^ downRight;
+    uint64_t downTwos = (downLeft & down[1]) | (downRight & (downLeft ^ down[1]));
+    uint64_t midOnes = midLeft ^ midRight;
+    uint64_t midTwos = midLeft & midRight;
+
+    // Add the ones, then the twos with the carry, then the fours
+    uint64_t ones = upOnes ^ downOnes ^ midOnes;
+    uint64_t carryTwos = (upOnes & downOnes) | (midOnes & (upOnes ^ downOnes));
+    uint64_t twosSum = upTwos ^ downTwos ^ midTwos;
+    uint64_t foursA = (upTwos & downTwos) | (midTwos & (upTwos ^ downTwos));
+    uint64_t twos = twosSum ^ carryTwos;
+    uint64_t foursB = twosSum & carryTwos;
+
+    planes[0] = ones;
+    planes[1] = twos;
+    planes[2] = foursA ^ foursB;
+    planes[3] = foursA & foursB;
+}
+
+#if defined(__AVX2__)
+// The same adder network as addNeighborPlanes, for four consecutive words at once.
+// Each row pointer points at the first of the four words.
+inline void addNeighborPlanesAvx2(const uint64_t* up, const uint64_t* mid, const uint64_t* down, uint64_t planes[4][4]) {
+    auto left = [](const uint64_t* row) {
+        __m256i center = _mm256_loadu_si256((const __m256i*)row);
+        __m256i before = _mm256_loadu_si256((const __m256i*)(row - 1));
+        return _mm256_or_si256(_mm256_slli_epi64(center, 1), _mm256_srli_epi64(before, 63));
+    };
+    auto right = [](const uint64_t* row) {
+        __m256i center = _mm256_loadu_si256((const __m256i*)row);
+        __m256i after = _mm256_loadu_si256((const __m256i*)(row + 1));
+        return _mm256_or_si256(_mm256_srli_epi64(center, 1), _mm256_slli_epi64(after, 63));
+    };
+    auto sumOfThree = [](__m256i a, __m256i b, __m256i c, __m256i& ones, __m256i& twos) {
+        __m256i ab = _mm256_xor_si256(a, b);
+        ones = _mm256_xor_si256(ab, c);
+        twos = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, ab));
+    };
+
+    __m256i upOnes, upTwos, downOnes, downTwos;
+    sumOfThree(left(up), _mm256_loadu_si256((const __m256i*)up), right(up), upOnes, upTwos);
+    sumOfThree(left(down), _mm256_loadu_si256((const __m256i*)down), right(down), downOnes, downTwos);
+    __m256i midLeft = left(mid);
+    __m256i midRight = right(mid);
+    __m256i midOnes = _mm256_xor_si256(midLeft, midRight);
+    __m256i midTwos = _mm256_and_si256(midLeft, midRight);
+
+    __m256i ones, carryTwos, twosSum, foursA;
+    sumOfThree(upOnes, downOnes, midOnes, ones, carryTwos);
+    sumOfThree(upTwos, downTwos, midTwos, twosSum, foursA);
+    __m256i twos = _mm256_xor_si256(twosSum, carryTwos);
+    __m256i foursB = _mm256_and_si256(twosSum, carryTwos);
+
+    _mm256_storeu_si256((__m256i*)planes[0], ones);
+    _mm256_storeu_si256((__m256i*)planes[1], twos);
+    _mm256_storeu_si256((__m256i*)planes[2], _mm256_xor_si256(foursA, foursB));
+    _mm256_storeu_si256((__m256i*)planes[3], _mm256_and_si256(foursA, foursB));
+}
+#endif
+
+// Byte i of spreadBits[v] is bit i of v, used to turn eight bits of a plane into eight bytes.
+struct SpreadTable {
+    uint64_t spreadBits[256];
+
+    SpreadTable() {
+        for (int v = 0; v < 256; v++) {
+            uint64_t spread = 0;
+            for (int bit = 0; bit < 8; bit++) {
+                if (v & (1 << bit)) {
+                    spread |= (uint64_t)1 << (bit * 8);
+                }
+            }
+            spreadBits[v] = spread;
+        }
+    }
+};
+
+// Writes the counts of 64 tiles from the four count planes into the tile bytes, keeping the state bits.
+inline void storeCounts(const uint64_t planes[4], Tile* tiles, int cellCount) {
+    static const SpreadTable table;
+    for (int cell = 0; cell < cellCount; cell += 8) {
+        int shift = cell;
+        uint64_t counts = table.spreadBits[(planes[0] >> shift) & 0xFF]
+                        | table.spreadBits[(planes[1] >> shift) & 0xFF] << 1
+                        | table.spreadBits[(planes[2] >> shift) & 0xFF] << 2
+                        | table.spreadBits[(planes[3] >> shift) & 0xFF] << 3;
+
+        int group = cellCount - cell < 8 ? cellCount - cell : 8;
+        if (group == 8) {
+            uint64_t bytes;
+            memcpy(&bytes, tiles + cell, 8);
+            bytes = (bytes & ~0x0F0F0F0F0F0F0F0FULL) | counts;
+            memcpy((void*)(tiles + cell), &bytes, 8);
+        }
+        else {
+            for (int i = 0; i < group; i++) {
+                tiles[cell + i].setAdjacentMineCount((int)((counts >> (i * 8)) & Tile::COUNT_MASK));
+            }
+        }
+    }
+}
+
+// Computes the adjacent mine count of every tile from the padded row bitmasks in one pass.
+// tiles points at the first playable tile and stride is the distance between rows of tiles.
+inline void countMinesFromRows(const vector<uint64_t>& mineRows, int rows, int cols, Tile* tiles, int stride) {
+    int rowWords = mineRowWords(cols);
+    int dataWords = rowWords - 2;
+
+    for (int row = 0; row < rows; row++) {
+        // Padded row row + 1 holds board row row
+        const uint64_t* up = &mineRows[(size_t)row * rowWords];
+        const uint64_t* mid = up + rowWords;
+        const uint64_t* down = mid + rowWords;
+        Tile* tileRow = tiles + (size_t)row * stride;
+
+        int word = 1;
+#if defined(__AVX2__)
+        uint64_t wide[4][4];
+        for (; word + 3 <= dataWords; word += 4) {
+            addNeighborPlanesAvx2(up + word, mid + word, down + word, wide);
+            for (int lane = 0; lane < 4; lane++) {
+                uint64_t planes[4] = {wide[0][lane], wide[1][lane], wide[2][lane], wide[3][lane]};
+                int firstCol = (word + lane - 1) * 64;
+                int cellCount = cols - firstCol < 64 ? cols - firstCol : 64;
+                storeCounts(planes, tileRow + firstCol, cellCount);
+            }
+        }
+#endif
+        for (; word <= dataWords; word++) {
+            uint64_t planes[4];
+            addNeighborPlanes(up + word - 1, mid + word - 1, down + word - 1, planes);
+            int firstCol = (word - 1) * 64;
+            int cellCount = cols - firstCol < 64 ? cols - firstCol : 64;
+            storeCounts(planes, tileRow + firstCol, cellCount);
+        }
+    }
+}
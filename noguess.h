@@ -0,0 +1,295 @@
+#pragma once
+#include "board.h"
+#include "floodfill.h"
+#include "rng.h"
+#include "solver.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+// Places mines so the whole board can be solved from the first click by deduction alone, with no guesses.
+//
+// The mines are placed as usual, with the 3x3 around the first click kept free so it opens, and the solver
+// plays the board from there, revealing every tile it deduces safe. When it gets stuck, the board is repaired
+// where it is stuck instead of being thrown away: one revealed number with undecided neighbors is picked and
+// either every mine among those neighbors is moved elsewhere, or every one of them is given a mine, whichever
+// moves fewer mines. Either way the number then decides all of them. Mines are moved to or from undecided
+// tiles away from the revealed area when there are any, so no other revealed number changes, and only the
+// numbers around the moved mines go back on the solver's worklist, so just that region is solved again.
+//
+// A repair can change numbers that earlier deductions were made from, so once the solver has revealed every
+// safe tile the board is played again from the first click with no repairs allowed to be needed. Any repair
+// in that pass is made the same way and the board is played again, until a pass needs none. If a board takes
+// too many repairs it is placed again from another stream of the seed.
+// Everything is drawn from the seed, so the same seed and first click always give the same board.
+class NoGuessGenerator {
+public:
+    static const int MAX_PASSES = 8;        // Plays of one placement before it is placed again
+    static const int MAX_ATTEMPTS = 32;     // Placements before giving up on a no-guess board
+    static const int PROBES = 32;           // Random tiles tried before scanning the board for a mine to move
+
+    // Work done by the last generate
+    bool solved = false;        // A no-guess board was found
+    int attempts = 0;
+    int passes = 0;
+    int repairs = 0;
+    int minesMoved = 0;
+
+    // Places the mines of a board with none placed. Flags already on the board are kept. Returns false, leaving
+    // an ordinary board from the seed, if no no-guess board was found, which only happens when the board is
+    // too dense for one to exist.
+    bool generate(Board& board, uint64_t seed, int safeRow, int safeCol) {
+        solved = false;
+        attempts = 0;
+        passes = 0;
+        repairs = 0;
+        minesMoved = 0;
+        int mines = board._mines;
+        int start = board.index(safeRow, safeCol);
+        // Sized for the worst case, so later boards of the same size allocate nothing
+        size_t tiles = (size_t)board._rows * board._cols;
+        flags.reserve(tiles);
+        stuck.reserve(tiles);
+        candidates.reserve(tiles);
+        floodFill.worklist.reserve(tiles);
+        floodFill.revealed.reserve(tiles);
+
+        // The solver trusts flags, so the player's flags are lifted while it plays
+        flags.clear();
+        for (int index = 0; index < (int)board.tiles.size(); index++) {
+            if (board.tiles[index].isFlagged()) {
+                flags.push_back(index);
+            }
+        }
+
+        while (!solved && attempts < MAX_ATTEMPTS) {
+            uint64_t placementSeed = attempts == 0 ? seed : Rng::stream(seed, (uint64_t)attempts);
+            attempts++;
+            board.clearMines(mines);
+            board.placeMines(placementSeed, safeRow, safeCol, true);
+            Rng rng(Rng::stream(placementSeed, 0));
+            int repairBudget = max(32, board._rows * board._cols / 8);
+
+            for (int pass = 0; pass < MAX_PASSES && !solved; pass++) {
+                passes++;
+                int passRepairs = play(board, start, rng, repairBudget);
+                hideAll(board);
+                if (passRepairs < 0) {
+                    break;
+                }
+                solved = passRepairs == 0;
+            }
+        }
+        if (!solved) {
+            board.clearMines(mines);
+            board.placeMines(seed, safeRow, safeCol, true);
+        }
+
+        board.seed = seed;
+        for (int index : flags) {
+            board.tiles[index].setFlagged(true);
+        }
+        return solved;
+    }
+
+private:
+    Solver solver;
+    FloodFill floodFill;
+    vector<int> flags;          // Tiles the player flagged before the mines were placed
+    vector<int> stuck;          // Revealed numbers with undecided neighbors
+    vector<int> candidates;     // Tiles a mine can move to or from
+
+    // Plays the board from the first click, revealing each deduced safe tile, and repairs it whenever the
+    // solver is stuck. Returns the repairs made, or -1 if more than the budget were needed.
+    int play(Board& board, int start, Rng& rng, int repairBudget) {
+        solver.reset(board);
+        reveal(board, start);
+        size_t safeTaken = 0;
+        int safeTiles = board._rows * board._cols - board._mines;
+        int passRepairs = 0;
+        while (true) {
+            solver.solve();
+            bool progressed = false;
+            for (; safeTaken < solver.safeTiles.size(); safeTaken++) {
+                int index = solver.safeTiles[safeTaken];
+                if (!board.tiles[index].isRevealed()) {
+                    reveal(board, index);
+                    progressed = true;
+                }
+            }
+            if (progressed) {
+                continue;
+            }
+            if (board.nonMinesRevealed == safeTiles) {
+                return passRepairs;
+            }
+            if (passRepairs == repairBudget || !repair(board, rng)) {
+                return -1;
+            }
+            passRepairs++;
+            repairs++;
+        }
+    }
+
+    void reveal(Board& board, int index) {
+        solver.notifyRevealed(floodFill.reveal(board, index));
+    }
+
+    // Hides every tile again for the next pass
+    void hideAll(Board& board) {
+        for (int row = 0; row < board._rows; row++) {
+            for (int col = 0; col < board._cols; col++) {
+                board.tileAt(row, col).setRevealed(false);
+            }
+        }
+        board.nonMinesRevealed = 0;
+    }
+
+    bool isUndecided(const Board& board, int index) const {
+        return !board.tiles[index].isRevealed() && solver.known[index] == Solver::UNKNOWN;
+    }
+
+    // Whether an undecided tile has no revealed neighbor, so moving a mine there changes no shown number
+    bool isInterior(const Board& board, int index) const {
+        for (int offset : board.neighborOffsets) {
+            const Tile& tile = board.tiles[index + offset];
+            if (tile.isRevealed() && !tile.isBorder()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Makes one stuck number decide all of its undecided neighbors. Returns false if the board cannot be
+    // repaired here: nothing revealed borders the undecided tiles, or there is nowhere to move mines.
+    bool repair(Board& board, Rng& rng) {
+        stuck.clear();
+        for (int row = 0; row < board._rows; row++) {
+            for (int col = 0; col < board._cols; col++) {
+                int index = board.index(row, col);
+                const Tile& tile = board.tiles[index];
+                if (!tile.isRevealed() || tile.adjacentMineCount() == 0) {
+                    continue;
+                }
+                for (int offset : board.neighborOffsets) {
+                    if (isUndecided(board, index + offset)) {
+                        stuck.push_back(index);
+                        break;
+                    }
+                }
+            }
+        }
+        if (stuck.empty()) {
+            return false;
+        }
+
+        int number = stuck[rng.below(stuck.size())];
+        int undecided = 0;
+        int mined = 0;
+        for (int offset : board.neighborOffsets) {
+            int neighbor = number + offset;
+            if (isUndecided(board, neighbor)) {
+                undecided++;
+                mined += board.tiles[neighbor].isMined();
+            }
+        }
+
+        // Clear the neighbors of their mines, or fill them, whichever moves fewer
+        bool clear = mined <= undecided - mined;
+        for (int offset : board.neighborOffsets) {
+            int neighbor = number + offset;
+            if (!isUndecided(board, neighbor) || board.tiles[neighbor].isMined() != clear) {
+                continue;
+            }
+            int other = pickTile(board, number, !clear, rng);
+            if (other < 0) {
+                return false;
+            }
+            if (clear) {
+                moveMine(board, neighbor, other);
+            }
+            else {
+                moveMine(board, other, neighbor);
+            }
+        }
+        return true;
+    }
+
+    // An undecided tile outside the number's neighborhood, with a mine or without one, preferring tiles away
+    // from the revealed area. Returns -1 if there is none.
+    int pickTile(const Board& board, int number, bool mined, Rng& rng) {
+        auto fits = [&](int index) {
+            bool nearNumber = abs(board.rowOf(index) - board.rowOf(number)) <= 1
+                              && abs(board.colOf(index) - board.colOf(number)) <= 1;
+            return !nearNumber && isUndecided(board, index) && board.tiles[index].isMined() == mined;
+        };
+        for (int probe = 0; probe < PROBES; probe++) {
+            int index = board.index((int)rng.below((uint64_t)board._rows), (int)rng.below((uint64_t)board._cols));
+            if (fits(index) && isInterior(board, index)) {
+                return index;
+            }
+        }
+
+        candidates.clear();
+        int interiorCount = 0;
+        for (int row = 0; row < board._rows; row++) {
+            for (int col = 0; col < board._cols; col++) {
+                int index = board.index(row, col);
+                if (!fits(index)) {
+                    continue;
+                }
+                // Interior tiles are kept at the front
+                candidates.push_back(index);
+                if (isInterior(board, index)) {
+                    swap(candidates[interiorCount++], candidates.back());
+                }
+            }
+        }
+        if (candidates.empty()) {
+            return -1;
+        }
+        size_t choices = interiorCount > 0 ? (size_t)interiorCount : candidates.size();
+        return candidates[rng.below(choices)];
+    }
+
+    // Moves a mine between two undecided tiles, updating the counts around both
+    void moveMine(Board& board, int from, int to) {
+        board.tiles[from].setMined(false);
+        board.tiles[to].setMined(true);
+        board.clearMineBit(board.rowOf(from), board.colOf(from));
+        board.setMineBit(board.rowOf(to), board.colOf(to));
+        *find(board.mineIndices.begin(), board.mineIndices.end(), from) = to;
+        minesMoved++;
+
+        for (int offset : board.neighborOffsets) {
+            Tile& tile = board.tiles[from + offset];
+            if (!tile.isBorder()) {
+                tile.setAdjacentMineCount(tile.adjacentMineCount() - 1);
+            }
+        }
+        for (int offset : board.neighborOffsets) {
+            Tile& tile = board.tiles[to + offset];
+            if (!tile.isBorder()) {
+                tile.setAdjacentMineCount(tile.adjacentMineCount() + 1);
+            }
+        }
+        solver.notifyMineMoved(from);
+        solver.notifyMineMoved(to);
+
+        // A revealed number that dropped to zero would have opened its neighbors
+        for (int offset : board.neighborOffsets) {
+            int neighbor = from + offset;
+            const Tile& tile = board.tiles[neighbor];
+            if (tile.isRevealed() && !tile.isBorder() && tile.adjacentMineCount() == 0) {
+                for (int around : board.neighborOffsets) {
+                    if (!board.tiles[neighbor + around].isRevealed()) {
+                        reveal(board, neighbor + around);
+                    }
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,465 @@
+#pragma once
+#include "board.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Exact mine probabilities of every hidden tile, from the same visible state the solver uses: revealed counts
+// and flags, with flags trusted as mines.
+//
+// Hidden tiles next to a revealed number form the frontier; every other hidden tile is unconstrained.
+// Frontier tiles around exactly the same numbers are interchangeable, so they are merged into one group and
+// enumerated by how many mines the group holds. The groups split into components that share no number, and
+// each component is enumerated on its own with backtracking, pruning as soon as a number has too many or too
+// few mines left. A component's result is the number of layouts for each count of mines in it, and how many
+// mines each group holds over those layouts.
+// The components are then combined through the mines left over for the unconstrained tiles: a frontier with
+// m mines leaves C(unconstrained, remaining - m) ways to place the rest. Those weights are taken in log space
+// since they overflow a double on large boards. Components are enumerated in parallel on a thread pool.
+class ProbabilityEngine {
+public:
+    vector<double> probability;     // Mine probability of each tile index: 1 for flags, 0 for revealed tiles
+    int frontierTiles = 0;
+    int unconstrainedTiles = 0;
+    int componentCount = 0;
+
+    explicit ProbabilityEngine(int threads = (int)thread::hardware_concurrency()) : pool(threads) {
+    }
+
+    // Computes the probability of every tile on the board.
+    // Returns false if no layout of the mines matches what is visible, for example after a wrong flag.
+    bool compute(const Board& board) {
+        board_ = &board;
+        probability.assign(board.tiles.size(), 0.0);
+        if (!buildConstraints()) {
+            return false;
+        }
+        buildGroups();
+        findComponents();
+
+        // Small components are faster to enumerate than to hand to another thread
+        for (Component& component : components) {
+            if (component.end - component.begin >= PARALLEL_MIN_GROUPS && pool.size() > 1) {
+                Component* task = &component;
+                pool.submit([this, task]() { enumerate(*task); });
+            }
+            else {
+                enumerate(component);
+            }
+        }
+        pool.wait();
+
+        return combine();
+    }
+
+private:
+    // Components with fewer groups than this are enumerated on the calling thread
+    static const int PARALLEL_MIN_GROUPS = 12;
+
+    // A revealed number and the frontier tiles around it
+    struct Constraint {
+        int need = 0;           // Mines still missing around the number
+        int assigned = 0;       // Mines among its tiles assigned so far during enumeration
+        int unassigned = 0;     // Its tiles not assigned yet during enumeration
+    };
+
+    // Groups that share no number with any other group, enumerated on their own
+    struct Component {
+        int begin = 0;              // Range of its groups in order
+        int end = 0;
+        int maxMines = 0;
+        vector<double> layouts;     // layouts[k]: number of layouts with k mines in the component
+        vector<double> groupMines;  // groupMines[i * (maxMines + 1) + k]: mines in group i summed over those layouts
+        vector<int> mined;          // Mines in each group during enumeration
+    };
+
+    ThreadPool pool;
+    const Board* board_ = nullptr;
+    int remainingMines = 0;             // Mines minus flags
+
+    vector<Constraint> constraints;
+    vector<int> constraintTiles;        // Frontier tile ids of each constraint, from constraintStart
+    vector<int> constraintStart;
+    vector<int> frontierIndex;          // Tile index of each frontier tile id
+    vector<int> frontierId;             // Frontier tile id of each tile index, or -1
+
+    vector<int> groupTiles;             // Frontier tile ids of each group, from groupStart
+    vector<int> groupStart;
+    vector<int> groupConstraints;       // Constraint ids of each group, from groupConstraintStart
+    vector<int> groupConstraintStart;
+    vector<int> constraintGroups;       // Group ids of each constraint, from constraintGroupStart
+    vector<int> constraintGroupStart;
+
+    vector<int> order;                  // Group ids by component, in enumeration order
+    vector<Component> components;
+    vector<double> logFactorials;       // log(n!) for n up to the most unconstrained tiles seen
+
+    // Zeros count too: a flag next to one means no layout matches
+    bool isNumber(int index) const {
+        const Tile& tile = board_->tiles[index];
+        return tile.isRevealed() && !tile.isBorder() && !tile.isMined();
+    }
+
+    int groupSize(int group) const {
+        return groupStart[group + 1] - groupStart[group];
+    }
+
+    // Finds the frontier and the constraint of every number around it.
+    bool buildConstraints() {
+        const Board& board = *board_;
+        frontierId.assign(board.tiles.size(), -1);
+        frontierIndex.clear();
+        constraints.clear();
+        constraintTiles.clear();
+        constraintStart.assign(1, 0);
+        remainingMines = board._mines;
+        unconstrainedTiles = 0;
+
+        for (int row = 0; row < board._rows; row++) {
+            for (int col = 0; col < board._cols; col++) {
+                int index = board.index(row, col);
+                const Tile& tile = board.tiles[index];
+                if (tile.isFlagged()) {
+                    remainingMines--;
+                    probability[index] = 1.0;
+                    continue;
+                }
+                if (!isNumber(index)) {
+                    continue;
+                }
+
+                Constraint constraint;
+                constraint.need = tile.adjacentMineCount();
+                for (int offset : board.neighborOffsets) {
+                    int neighbor = index + offset;
+                    const Tile& around = board.tiles[neighbor];
+                    if (around.isFlagged()) {
+                        constraint.need--;
+                    }
+                    else if (!around.isRevealed()) {
+                        if (frontierId[neighbor] < 0) {
+                            frontierId[neighbor] = (int)frontierIndex.size();
+                            frontierIndex.push_back(neighbor);
+                        }
+                        constraintTiles.push_back(frontierId[neighbor]);
+                        constraint.unassigned++;
+                    }
+                }
+                if (constraint.need < 0 || constraint.need > constraint.unassigned) {
+                    return false;
+                }
+                if (constraint.unassigned == 0) {
+                    continue;
+                }
+                constraints.push_back(constraint);
+                constraintStart.push_back((int)constraintTiles.size());
+            }
+        }
+        if (remainingMines < 0) {
+            return false;
+        }
+
+        for (int row = 0; row < board._rows; row++) {
+            for (int col = 0; col < board._cols; col++) {
+                int index = board.index(row, col);
+                const Tile& tile = board.tiles[index];
+                unconstrainedTiles += !tile.isRevealed() && !tile.isFlagged() && frontierId[index] < 0;
+            }
+        }
+        frontierTiles = (int)frontierIndex.size();
+        return true;
+    }
+
+    // Merges frontier tiles around the same numbers into groups, and links groups and constraints.
+    void buildGroups() {
+        // The constraints of each tile, in increasing order
+        vector<int> tileConstraintStart(frontierTiles + 1, 0);
+        for (int tile : constraintTiles) {
+            tileConstraintStart[tile + 1]++;
+        }
+        for (int tile = 0; tile < frontierTiles; tile++) {
+            tileConstraintStart[tile + 1] += tileConstraintStart[tile];
+        }
+        vector<int> tileConstraints(constraintTiles.size());
+        vector<int> fill(tileConstraintStart.begin(), tileConstraintStart.end() - 1);
+        for (int c = 0; c < (int)constraints.size(); c++) {
+            for (int i = constraintStart[c]; i < constraintStart[c + 1]; i++) {
+                tileConstraints[fill[constraintTiles[i]]++] = c;
+            }
+        }
+
+        // Sorting the tiles by their constraint lists puts the tiles of each group next to each other
+        auto constraintsOf = [&](int tile) {
+            return make_pair(tileConstraints.begin() + tileConstraintStart[tile], tileConstraints.begin() + tileConstraintStart[tile + 1]);
+        };
+        groupTiles.resize(frontierTiles);
+        for (int tile = 0; tile < frontierTiles; tile++) {
+            groupTiles[tile] = tile;
+        }
+        sort(groupTiles.begin(), groupTiles.end(), [&](int a, int b) {
+            auto listA = constraintsOf(a);
+            auto listB = constraintsOf(b);
+            return lexicographical_compare(listA.first, listA.second, listB.first, listB.second);
+        });
+
+        groupStart.clear();
+        groupConstraints.clear();
+        groupConstraintStart.assign(1, 0);
+        for (int i = 0; i < frontierTiles; i++) {
+            auto list = constraintsOf(groupTiles[i]);
+            if (i > 0) {
+                auto previous = constraintsOf(groupTiles[i - 1]);
+                if (equal(list.first, list.second, previous.first, previous.second)) {
+                    continue;
+                }
+            }
+            groupStart.push_back(i);
+            groupConstraints.insert(groupConstraints.end(), list.first, list.second);
+            groupConstraintStart.push_back((int)groupConstraints.size());
+        }
+        groupStart.push_back(frontierTiles);
+
+        // The groups of each constraint
+        int groupCount = (int)groupStart.size() - 1;
+        constraintGroupStart.assign(constraints.size() + 1, 0);
+        for (int c : groupConstraints) {
+            constraintGroupStart[c + 1]++;
+        }
+        for (int c = 0; c < (int)constraints.size(); c++) {
+            constraintGroupStart[c + 1] += constraintGroupStart[c];
+        }
+        constraintGroups.resize(groupConstraints.size());
+        fill.assign(constraintGroupStart.begin(), constraintGroupStart.end() - 1);
+        for (int group = 0; group < groupCount; group++) {
+            for (int i = groupConstraintStart[group]; i < groupConstraintStart[group + 1]; i++) {
+                constraintGroups[fill[groupConstraints[i]]++] = group;
+            }
+        }
+    }
+
+    // Splits the groups into components, each in breadth-first order so its constraints close early
+    // during enumeration and prune the search sooner.
+    void findComponents() {
+        int groupCount = (int)groupStart.size() - 1;
+        order.clear();
+        components.clear();
+        vector<uint8_t> visited(groupCount, 0);
+        for (int start = 0; start < groupCount; start++) {
+            if (visited[start]) {
+                continue;
+            }
+            Component component;
+            component.begin = (int)order.size();
+            visited[start] = 1;
+            order.push_back(start);
+            for (int next = component.begin; next < (int)order.size(); next++) {
+                int group = order[next];
+                for (int i = groupConstraintStart[group]; i < groupConstraintStart[group + 1]; i++) {
+                    int c = groupConstraints[i];
+                    for (int j = constraintGroupStart[c]; j < constraintGroupStart[c + 1]; j++) {
+                        int other = constraintGroups[j];
+                        if (!visited[other]) {
+                            visited[other] = 1;
+                            order.push_back(other);
+                        }
+                    }
+                }
+            }
+            component.end = (int)order.size();
+            components.push_back(move(component));
+        }
+        componentCount = (int)components.size();
+    }
+
+    // Assigns mines to a group and updates its constraints. Returns false if one of them can no longer be met.
+    bool assign(int group, int mines) {
+        int size = groupSize(group);
+        bool possible = true;
+        for (int i = groupConstraintStart[group]; i < groupConstraintStart[group + 1]; i++) {
+            Constraint& constraint = constraints[groupConstraints[i]];
+            constraint.unassigned -= size;
+            constraint.assigned += mines;
+            if (constraint.assigned > constraint.need || constraint.assigned + constraint.unassigned < constraint.need) {
+                possible = false;
+            }
+        }
+        return possible;
+    }
+
+    void unassign(int group, int mines) {
+        int size = groupSize(group);
+        for (int i = groupConstraintStart[group]; i < groupConstraintStart[group + 1]; i++) {
+            Constraint& constraint = constraints[groupConstraints[i]];
+            constraint.unassigned += size;
+            constraint.assigned -= mines;
+        }
+    }
+
+    // Counts every layout of the component that meets all its constraints.
+    // Components touch disjoint groups and constraints, so several can run at once.
+    void enumerate(Component& component) {
+        int size = component.end - component.begin;
+        int tiles = 0;
+        for (int i = component.begin; i < component.end; i++) {
+            tiles += groupSize(order[i]);
+        }
+        component.maxMines = min(tiles, remainingMines);
+        component.layouts.assign(component.maxMines + 1, 0.0);
+        component.groupMines.assign((size_t)size * (component.maxMines + 1), 0.0);
+        component.mined.assign(size, 0);
+        search(component, 0, 0, 1.0);
+    }
+
+    // ways is the number of layouts of the groups assigned so far
+    void search(Component& component, int position, int mines, double ways) {
+        int size = component.end - component.begin;
+        if (position == size) {
+            int stride = component.maxMines + 1;
+            component.layouts[mines] += ways;
+            for (int i = 0; i < size; i++) {
+                component.groupMines[(size_t)i * stride + mines] += ways * component.mined[i];
+            }
+            return;
+        }
+
+        int group = order[component.begin + position];
+        int tiles = groupSize(group);
+        double choose = 1.0;    // C(tiles, j), updated as j grows
+        for (int j = 0; j <= tiles && mines + j <= component.maxMines; j++) {
+            if (j > 0) {
+                choose = choose * (tiles - j + 1) / j;
+            }
+            component.mined[position] = j;
+            if (assign(group, j)) {
+                search(component, position + 1, mines + j, ways * choose);
+            }
+            unassign(group, j);
+        }
+        component.mined[position] = 0;
+    }
+
+    // From a table of log(n!) kept by the engine. lgamma would also do, but it sets the global signgam, which
+    // races when engines run on several threads.
+    double logChoose(int n, int k) {
+        while ((int)logFactorials.size() <= n) {
+            double next = (double)logFactorials.size();
+            logFactorials.push_back(logFactorials.empty() ? 0.0 : logFactorials.back() + log(next));
+        }
+        return logFactorials[n] - logFactorials[k] - logFactorials[n - k];
+    }
+
+    static vector<double> convolve(const vector<double>& a, const vector<double>& b) {
+        vector<double> result(a.size() + b.size() - 1, 0.0);
+        for (size_t i = 0; i < a.size(); i++) {
+            if (a[i] == 0.0) {
+                continue;
+            }
+            for (size_t j = 0; j < b.size(); j++) {
+                result[i + j] += a[i] * b[j];
+            }
+        }
+        return result;
+    }
+
+    // Combines the components through the mines left for the unconstrained tiles.
+    bool combine() {
+        // Scale each component so its largest count is 1; probabilities are ratios, so the scale cancels
+        for (Component& component : components) {
+            double largest = *max_element(component.layouts.begin(), component.layouts.end());
+            if (largest == 0.0) {
+                return false;
+            }
+            for (double& count : component.layouts) {
+                count /= largest;
+            }
+            for (double& count : component.groupMines) {
+                count /= largest;
+            }
+        }
+
+        // prefix[c] combines components before c, suffix[c] components from c on
+        int count = (int)components.size();
+        vector<vector<double>> prefix(count + 1, vector<double>(1, 1.0));
+        vector<vector<double>> suffix(count + 1, vector<double>(1, 1.0));
+        for (int c = 0; c < count; c++) {
+            prefix[c + 1] = convolve(prefix[c], components[c].layouts);
+        }
+        for (int c = count - 1; c >= 0; c--) {
+            suffix[c] = convolve(components[c].layouts, suffix[c + 1]);
+        }
+        const vector<double>& frontier = prefix[count];
+
+        // weight[m]: ways to place the other mines in the unconstrained tiles when the frontier holds m,
+        // relative to the largest
+        int maxFrontierMines = (int)frontier.size() - 1;
+        vector<double> weight(maxFrontierMines + 1, 0.0);
+        double largestLog = -HUGE_VAL;
+        for (int m = 0; m <= maxFrontierMines; m++) {
+            int rest = remainingMines - m;
+            if (rest >= 0 && rest <= unconstrainedTiles && frontier[m] > 0.0) {
+                largestLog = max(largestLog, logChoose(unconstrainedTiles, rest));
+            }
+        }
+        if (largestLog == -HUGE_VAL) {
+            return false;
+        }
+        double total = 0.0;
+        double unconstrainedMines = 0.0;
+        for (int m = 0; m <= maxFrontierMines; m++) {
+            int rest = remainingMines - m;
+            if (rest >= 0 && rest <= unconstrainedTiles) {
+                weight[m] = exp(logChoose(unconstrainedTiles, rest) - largestLog);
+                total += frontier[m] * weight[m];
+                unconstrainedMines += frontier[m] * weight[m] * rest;
+            }
+        }
+        if (total == 0.0) {
+            return false;
+        }
+
+        for (int c = 0; c < count; c++) {
+            const Component& component = components[c];
+            vector<double> others = convolve(prefix[c], suffix[c + 1]);
+            int size = component.end - component.begin;
+            int stride = component.maxMines + 1;
+            for (int i = 0; i < size; i++) {
+                double mines = 0.0;
+                for (int k = 0; k <= component.maxMines; k++) {
+                    double groupMines = component.groupMines[(size_t)i * stride + k];
+                    if (groupMines == 0.0) {
+                        continue;
+                    }
+                    for (int j = 0; j < (int)others.size() && k + j <= maxFrontierMines; j++) {
+                        mines += groupMines * others[j] * weight[k + j];
+                    }
+                }
+
+                // Tiles of a group are interchangeable, each holds an equal share of its mines
+                int group = order[component.begin + i];
+                double tileProbability = mines / total / groupSize(group);
+                for (int t = groupStart[group]; t < groupStart[group + 1]; t++) {
+                    probability[frontierIndex[groupTiles[t]]] = tileProbability;
+                }
+            }
+        }
+
+        if (unconstrainedTiles > 0) {
+            double unconstrainedProbability = unconstrainedMines / total / unconstrainedTiles;
+            const Board& board = *board_;
+            for (int row = 0; row < board._rows; row++) {
+                for (int col = 0; col < board._cols; col++) {
+                    int index = board.index(row, col);
+                    const Tile& tile = board.tiles[index];
+                    if (!tile.isRevealed() && !tile.isFlagged() && frontierId[index] < 0) {
+                        probability[index] = unconstrainedProbability;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+};
@@ -0,0 +1,218 @@
+#pragma once
+#include "game.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+// Replays record a game as its seed and board followed by the player's actions, which is enough to
+// re-execute it exactly since the mines are placed from the seed on the first reveal.
+//
+// Layout: char[4] "MSRP", then varints version, rows, cols, mines, board mode (bit 0 safe neighborhood, bit 1
+// no-guess placement), and the seed as 8 little-endian bytes. Each event is a varint of (milliseconds since the
+// last event << 3 | type), followed for tile events by the varint row * cols + col. Times are play time, which
+// stops while paused, as shown on the timer. The END event closes the replay with the outcome (0 playing, 1 won,
+// 2 lost) and the number of tiles revealed, so a player can check it reached the same state.
+// A reveal or flag typically takes two to four bytes.
+
+enum ReplayEvent {
+    REPLAY_REVEAL,
+    REPLAY_FLAG,
+    REPLAY_CHORD,
+    REPLAY_PAUSE,
+    REPLAY_RESUME,
+    REPLAY_END
+};
+
+const uint64_t REPLAY_VERSION = 1;
+const uint64_t REPLAY_SAFE_NEIGHBORHOOD = 1;    // Bits of the board mode
+const uint64_t REPLAY_NO_GUESS = 2;
+const int REPLAY_MAX_TILES = 1 << 24;       // Larger boards in a replay are rejected as malformed
+
+inline void writeVarint(vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+// Reads a varint and advances in. Returns false if the data ends first or the varint is too long.
+inline bool readVarint(const uint8_t*& in, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && in < end; shift += 7) {
+        uint8_t byte = *in++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Appends the events of one game to a byte buffer as they happen.
+class ReplayWriter {
+public:
+    vector<uint8_t> data;
+    uint64_t lastTime = 0;      // Play time of the last event, in milliseconds
+    int cols = 0;
+    bool ended = false;
+
+    // Starts the recording of a new game, before its first action.
+    void begin(const Game& game) {
+        data.clear();
+        data.reserve(1024);
+        lastTime = 0;
+        cols = game.cols();
+        ended = false;
+
+        for (char magic : {'M', 'S', 'R', 'P'}) {
+            data.push_back((uint8_t)magic);
+        }
+        writeVarint(data, REPLAY_VERSION);
+        writeVarint(data, (uint64_t)game.rows());
+        writeVarint(data, (uint64_t)game.cols());
+        writeVarint(data, (uint64_t)game.mines());
+        uint64_t mode = (game.safeNeighborhood ? REPLAY_SAFE_NEIGHBORHOOD : 0) | (game.noGuess ? REPLAY_NO_GUESS : 0);
+        writeVarint(data, mode);
+        for (int i = 0; i < 8; i++) {
+            data.push_back((uint8_t)(game.seed >> (8 * i)));
+        }
+    }
+
+    void event(ReplayEvent type, uint64_t milliseconds) {
+        if (ended) {
+            return;
+        }
+        // Times never go backwards, even if the clock is adjusted
+        uint64_t delta = milliseconds > lastTime ? milliseconds - lastTime : 0;
+        lastTime += delta;
+        writeVarint(data, delta << 3 | type);
+    }
+
+    void tileEvent(ReplayEvent type, int row, int col, uint64_t milliseconds) {
+        if (ended) {
+            return;
+        }
+        event(type, milliseconds);
+        writeVarint(data, (uint64_t)row * cols + col);
+    }
+
+    // Closes the recording with the state the game reached.
+    void end(const Game& game, uint64_t milliseconds) {
+        if (ended) {
+            return;
+        }
+        event(REPLAY_END, milliseconds);
+        writeVarint(data, game.gameWon ? 1 : game.gameLost ? 2 : 0);
+        writeVarint(data, (uint64_t)game.board.nonMinesRevealed);
+        ended = true;
+    }
+};
+
+// What a replay claimed and what re-executing it gave
+struct ReplayResult {
+    int rows = 0;
+    int cols = 0;
+    int mines = 0;
+    uint64_t seed = 0;
+    uint64_t playMilliseconds = 0;  // Play time at the end of the game
+    int events = 0;
+    bool won = false;
+    bool lost = false;
+};
+
+// Re-executes replays against a headless game as fast as possible, reusing one game between replays.
+class ReplayPlayer {
+public:
+    Game game = Game(1, 1, 0, 0);
+
+    // Plays a replay to its end. Returns false if the replay is malformed, or if the game did not reach the
+    // outcome and revealed tile count recorded at its end.
+    bool play(const uint8_t* data, size_t size, ReplayResult& result) {
+        result = ReplayResult();
+        const uint8_t* in = data;
+        const uint8_t* end = data + size;
+        if (size < 4 || memcmp(in, "MSRP", 4) != 0) {
+            return false;
+        }
+        in += 4;
+
+        uint64_t version, rows, cols, mines, mode;
+        if (!readVarint(in, end, version) || version != REPLAY_VERSION || !readVarint(in, end, rows)
+            || !readVarint(in, end, cols) || !readVarint(in, end, mines) || !readVarint(in, end, mode)) {
+            return false;
+        }
+        // Each side is bounded before the product, which could otherwise wrap around to a small number
+        if (rows < 1 || cols < 1 || rows > (uint64_t)REPLAY_MAX_TILES || cols > (uint64_t)REPLAY_MAX_TILES
+            || rows * cols > (uint64_t)REPLAY_MAX_TILES || mines > rows * cols || end - in < 8) {
+            return false;
+        }
+        uint64_t seed = 0;
+        for (int i = 0; i < 8; i++) {
+            seed |= (uint64_t)in[i] << (8 * i);
+        }
+        in += 8;
+
+        result.rows = (int)rows;
+        result.cols = (int)cols;
+        result.mines = (int)mines;
+        result.seed = seed;
+        if (game.rows() == result.rows && game.cols() == result.cols && game.mines() == result.mines) {
+            game.reset(seed);
+        }
+        else {
+            game = Game(result.rows, result.cols, result.mines, seed);
+        }
+        game.trackChanges = false;
+        game.safeNeighborhood = (mode & REPLAY_SAFE_NEIGHBORHOOD) != 0;
+        game.noGuess = (mode & REPLAY_NO_GUESS) != 0;
+
+        uint64_t time = 0;
+        while (in < end) {
+            uint64_t header;
+            if (!readVarint(in, end, header)) {
+                return false;
+            }
+            time += header >> 3;
+            int type = (int)(header & 7);
+            result.events++;
+
+            if (type == REPLAY_END) {
+                uint64_t outcome, revealed;
+                if (!readVarint(in, end, outcome) || !readVarint(in, end, revealed) || in != end) {
+                    return false;
+                }
+                result.playMilliseconds = time;
+                result.won = game.gameWon;
+                result.lost = game.gameLost;
+                uint64_t reached = game.gameWon ? 1 : game.gameLost ? 2 : 0;
+                return outcome == reached && revealed == (uint64_t)game.board.nonMinesRevealed;
+            }
+            if (type == REPLAY_PAUSE || type == REPLAY_RESUME) {
+                continue;
+            }
+            if (type > REPLAY_END) {
+                return false;
+            }
+
+            uint64_t tile;
+            if (!readVarint(in, end, tile) || tile >= rows * cols) {
+                return false;
+            }
+            int row = (int)(tile / cols);
+            int col = (int)(tile % cols);
+            if (type == REPLAY_REVEAL) {
+                game.reveal(row, col);
+            }
+            else if (type == REPLAY_FLAG) {
+                game.toggleFlag(row, col);
+            }
+            else {
+                game.chord(row, col);
+            }
+        }
+        return false;   // No END event
+    }
+};
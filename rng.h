@@ -0,0 +1,50 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+using namespace std;
+
+// A small seeded random number generator (SplitMix64) that gives the same sequence on every platform
+// and compiler, unlike the standard distributions, so a seed always reproduces the same board.
+class Rng {
+public:
+    uint64_t state;
+
+    explicit Rng(uint64_t seed) {
+        state = seed;
+    }
+
+    uint64_t next() {
+        state += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform integer in [0, bound). Values below the threshold are rejected so every result is equally likely.
+    uint64_t below(uint64_t bound) {
+        uint64_t threshold = (0 - bound) % bound;
+        uint64_t value;
+        do {
+            value = next();
+        } while (value < threshold);
+        return value % bound;
+    }
+
+    // Mixes a seed with a stream number, giving independent generators for each board or thread
+    static uint64_t stream(uint64_t seed, uint64_t index) {
+        Rng mixer(seed ^ (index * 0xD1B54A32D192ED03ULL));
+        mixer.next();
+        return mixer.next();
+    }
+};
+
+// A fresh seed for a new game
+inline uint64_t newSeed() {
+    random_device device;
+    uint64_t entropy = ((uint64_t)device() << 32) ^ device();
+    uint64_t time = (uint64_t)chrono::high_resolution_clock::now().time_since_epoch().count();
+    return Rng::stream(entropy, time);
+}
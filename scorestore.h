@@ -0,0 +1,443 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// One won game
+struct Score {
+    int rows = 0;
+    int cols = 0;
+    int mines = 0;
+    uint32_t seconds = 0;   // Time to win, as shown on the timer
+    string name;
+    vector<uint8_t> replay; // Recording of the game (replay.h), empty if there is none
+};
+
+// CRC-32 (IEEE), used to detect records that were only partly written
+inline uint32_t crc32(const uint8_t* data, size_t size) {
+    static const struct Table {
+        uint32_t entries[256];
+        Table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; bit++) {
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+                }
+                entries[i] = crc;
+            }
+        }
+    } table;
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) {
+        crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// Leaderboard storage. Results are appended to a log file and kept in memory as the best TOP_COUNT times
+// of each board configuration (rows, cols, mines), so adding a result and reading the leaderboard never
+// touch the disk on the calling thread. A writer thread appends the queued results, rewrites the log with
+// only the kept results once it has grown (compaction), and exports the current configuration's top five
+// to the text leaderboard ("MM:SS, Name" per line) that the leaderboard window reads.
+//
+// Log layout: char[4] "MSSL", uint32 version, then records of uint32 payload size, uint32 CRC-32 of the
+// payload, and the payload: uint32 rows, cols, mines, seconds, uint16 name length and the name, then
+// optionally uint32 replay length and the replay.
+// Records are only ever appended, and a compacted log is written to a temporary file and renamed over the
+// old one, so a crash can at worst leave a torn last record. Loading stops at the first record that is
+// short or fails its CRC and truncates it away; every record before it is intact.
+class ScoreStore {
+public:
+    static const int TOP_COUNT = 10;        // Results kept per board configuration
+    static const int EXPORT_COUNT = 5;      // Results in the text leaderboard
+
+    // Loads the log and starts the writer thread. The text leaderboard is exported for the given board.
+    // If there is no log yet, the results already in the text leaderboard are imported into it.
+    ScoreStore(const string& logPath, const string& leaderboardPath, int rows, int cols, int mines) {
+        _logPath = logPath;
+        _leaderboardPath = leaderboardPath;
+        exportConfig = Config(rows, cols, mines);
+
+        bool logExists = filesystem::exists(_logPath);
+        load();
+        if (!logExists) {
+            importLeaderboard();
+        }
+        writer = thread([this]() { writeLoop(); });
+    }
+
+    // Writes everything still queued before returning
+    ~ScoreStore() {
+        {
+            lock_guard<mutex> lock(storeMutex);
+            stopping = true;
+        }
+        queueReady.notify_all();
+        writer.join();
+    }
+
+    ScoreStore(const ScoreStore&) = delete;
+    ScoreStore& operator=(const ScoreStore&) = delete;
+
+    // Records a result and queues it for the writer thread.
+    // Returns its rank among the kept results of its board (0 is the best), or -1 if it did not make it.
+    int add(const Score& score) {
+        int rank;
+        {
+            lock_guard<mutex> lock(storeMutex);
+            rank = insert(score);
+            queue.push_back(score);
+            pending++;
+        }
+        queueReady.notify_one();
+        return rank;
+    }
+
+    // The kept results of a board, best first
+    vector<Score> top(int rows, int cols, int mines) {
+        lock_guard<mutex> lock(storeMutex);
+        auto found = index.find(Config(rows, cols, mines));
+        return found == index.end() ? vector<Score>() : found->second;
+    }
+
+    // Reads the intact records of a log into scores.
+    // Returns the size of the header and intact records, or 0 if the data is not a score log.
+    static size_t parseLog(const vector<uint8_t>& data, vector<Score>& scores) {
+        vector<uint8_t> expected;
+        header(expected);
+        if (data.size() < HEADER_SIZE || memcmp(data.data(), expected.data(), HEADER_SIZE) != 0) {
+            return 0;
+        }
+
+        size_t offset = HEADER_SIZE;
+        while (offset + RECORD_HEADER_SIZE <= data.size()) {
+            uint32_t size = readValue(&data[offset]);
+            uint32_t crc = readValue(&data[offset + 4]);
+            const uint8_t* payload = &data[offset + RECORD_HEADER_SIZE];
+            Score score;
+            if (size > data.size() - offset - RECORD_HEADER_SIZE || crc32(payload, size) != crc || !decode(payload, size, score)) {
+                break;
+            }
+            scores.push_back(move(score));
+            offset += RECORD_HEADER_SIZE + size;
+        }
+        return offset;
+    }
+
+    // Whether every added result has been written and exported
+    bool idle() {
+        lock_guard<mutex> lock(storeMutex);
+        return pending == 0;
+    }
+
+    // Blocks until every added result has been written and exported
+    void flush() {
+        unique_lock<mutex> lock(storeMutex);
+        allWritten.wait(lock, [this]() { return pending == 0; });
+    }
+
+private:
+    typedef tuple<int, int, int> Config;    // rows, cols, mines
+
+    static const uint32_t VERSION = 1;
+    static const size_t HEADER_SIZE = 8;
+    static const size_t RECORD_HEADER_SIZE = 8;
+    static const size_t MIN_RECORDS_TO_COMPACT = 64;
+
+    string _logPath;
+    string _leaderboardPath;
+    Config exportConfig;
+
+    map<Config, vector<Score>> index;       // Kept results of each board, best first
+    vector<Score> queue;                    // Results waiting for the writer
+    int pending = 0;                        // Results added and not yet written
+    bool stopping = false;
+    mutex storeMutex;
+    condition_variable queueReady;
+    condition_variable allWritten;
+    thread writer;
+
+    FILE* log = nullptr;                    // Owned by the writer thread once it starts
+    size_t logRecords = 0;                  // Records in the log file, kept or not
+
+    static Config configOf(const Score& score) {
+        return Config(score.rows, score.cols, score.mines);
+    }
+
+    // Inserts into the index. Ties go before older results, as the text leaderboard always did.
+    int insert(const Score& score) {
+        vector<Score>& kept = index[configOf(score)];
+        auto position = lower_bound(kept.begin(), kept.end(), score.seconds,
+                                    [](const Score& existing, uint32_t seconds) { return existing.seconds < seconds; });
+        int rank = (int)(position - kept.begin());
+        if (rank >= TOP_COUNT) {
+            return -1;
+        }
+        kept.insert(position, score);
+        if ((int)kept.size() > TOP_COUNT) {
+            kept.pop_back();
+        }
+        return rank;
+    }
+
+    static void appendValue(vector<uint8_t>& out, uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            out.push_back((uint8_t)(value >> (8 * i)));
+        }
+    }
+
+    static uint32_t readValue(const uint8_t* in) {
+        return in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+    }
+
+    static void encode(const Score& score, vector<uint8_t>& out) {
+        vector<uint8_t> payload;
+        appendValue(payload, (uint32_t)score.rows);
+        appendValue(payload, (uint32_t)score.cols);
+        appendValue(payload, (uint32_t)score.mines);
+        appendValue(payload, score.seconds);
+        size_t nameLength = min(score.name.size(), (size_t)0xFFFF);
+        payload.push_back((uint8_t)nameLength);
+        payload.push_back((uint8_t)(nameLength >> 8));
+        payload.insert(payload.end(), score.name.begin(), score.name.begin() + nameLength);
+        if (!score.replay.empty()) {
+            appendValue(payload, (uint32_t)score.replay.size());
+            payload.insert(payload.end(), score.replay.begin(), score.replay.end());
+        }
+
+        appendValue(out, (uint32_t)payload.size());
+        appendValue(out, crc32(payload.data(), payload.size()));
+        out.insert(out.end(), payload.begin(), payload.end());
+    }
+
+    static bool decode(const uint8_t* payload, size_t size, Score& score) {
+        if (size < 18) {
+            return false;
+        }
+        score.rows = (int)readValue(payload);
+        score.cols = (int)readValue(payload + 4);
+        score.mines = (int)readValue(payload + 8);
+        score.seconds = readValue(payload + 12);
+        size_t nameLength = payload[16] | (size_t)payload[17] << 8;
+        if (18 + nameLength > size) {
+            return false;
+        }
+        score.name.assign((const char*)payload + 18, nameLength);
+
+        size_t offset = 18 + nameLength;
+        if (offset == size) {
+            return true;
+        }
+        if (size - offset < 4 || size - offset - 4 != readValue(payload + offset)) {
+            return false;
+        }
+        score.replay.assign(payload + offset + 4, payload + size);
+        return true;
+    }
+
+    static void header(vector<uint8_t>& out) {
+        out.insert(out.end(), {'M', 'S', 'S', 'L'});
+        appendValue(out, VERSION);
+    }
+
+    // Forces written data to the disk, so it survives a crash of the whole machine
+    static void sync(FILE* file) {
+        fflush(file);
+#if defined(_WIN32)
+        _commit(_fileno(file));
+#else
+        fsync(fileno(file));
+#endif
+    }
+
+    // Reads every intact record into the index and cuts off a torn tail.
+    void load() {
+        ifstream infile(_logPath, ios::binary);
+        vector<uint8_t> data((istreambuf_iterator<char>(infile)), istreambuf_iterator<char>());
+        infile.close();
+
+        vector<Score> scores;
+        size_t offset = parseLog(data, scores);
+        if (offset == 0) {
+            if (!data.empty()) {
+                cout << "Error: " << _logPath << " is not a score log, starting a new one." << endl;
+            }
+            rewriteLog(vector<Score>());
+            return;
+        }
+        for (const Score& score : scores) {
+            insert(score);
+        }
+        logRecords = scores.size();
+
+        if (offset != data.size()) {
+            cout << "Dropping " << data.size() - offset << " bytes of a partly written score from " << _logPath << "." << endl;
+            error_code error;
+            filesystem::resize_file(_logPath, offset, error);
+        }
+        log = fopen(_logPath.c_str(), "ab");
+        if (!log) {
+            cout << "Error: " << _logPath << " cannot open in append mode." << endl;
+        }
+    }
+
+    // Imports the "MM:SS, Name" lines of an existing text leaderboard for the exported board.
+    void importLeaderboard() {
+        ifstream infile(_leaderboardPath);
+        vector<string> lines;
+        string line;
+        while (getline(infile, line)) {
+            lines.push_back(line);
+        }
+
+        // Added worst first, since a result goes before older ones with the same time
+        for (int i = (int)lines.size() - 1; i >= 0; i--) {
+            const string& record = lines[i];
+            if (record.size() < 7 || !isdigit(record[0]) || !isdigit(record[1]) || record[2] != ':'
+                || !isdigit(record[3]) || !isdigit(record[4])) {
+                continue;
+            }
+            Score score;
+            tie(score.rows, score.cols, score.mines) = exportConfig;
+            score.seconds = (uint32_t)(stoi(record.substr(0, 2)) * 60 + stoi(record.substr(3, 2)));
+            score.name = record.substr(7);
+            add(score);
+        }
+    }
+
+    // Writes a new log holding only the given results to a temporary file and renames it over the log.
+    // The rename replaces the file in one step, so a crash leaves either the old log or the new one.
+    void rewriteLog(const vector<Score>& scores) {
+        if (log) {
+            fclose(log);
+            log = nullptr;
+        }
+
+        string temporaryPath = _logPath + ".tmp";
+        vector<uint8_t> data;
+        header(data);
+        for (const Score& score : scores) {
+            encode(score, data);
+        }
+        FILE* file = fopen(temporaryPath.c_str(), "wb");
+        if (!file) {
+            cout << "Error: " << temporaryPath << " cannot open in write mode." << endl;
+            return;
+        }
+        fwrite(data.data(), 1, data.size(), file);
+        sync(file);
+        fclose(file);
+
+        error_code error;
+        filesystem::rename(temporaryPath, _logPath, error);
+        if (error) {
+            cout << "Error: " << _logPath << " cannot be replaced: " << error.message() << endl;
+        }
+        logRecords = scores.size();
+        log = fopen(_logPath.c_str(), "ab");
+    }
+
+    // Whether the log needs compacting once a batch is written, with most of its records dropped out of the
+    // kept results, and if so the kept results, each board's worst first so loading them back keeps ties in order.
+    // Called with the lock held as the batch is taken from the queue, so the kept results are exactly those
+    // written by then: one added later would otherwise be written again after the compacted log.
+    bool keptToCompact(size_t batchSize, vector<Score>& kept) {
+        size_t keptCount = 0;
+        for (auto& entry : index) {
+            keptCount += entry.second.size();
+        }
+        size_t records = logRecords + batchSize;
+        if (records < MIN_RECORDS_TO_COMPACT || records <= 2 * keptCount) {
+            return false;
+        }
+        for (auto& entry : index) {
+            kept.insert(kept.end(), entry.second.rbegin(), entry.second.rend());
+        }
+        return true;
+    }
+
+    // Writes the top results of the exported board in the text leaderboard format.
+    void exportLeaderboard() {
+        vector<Score> best = top(get<0>(exportConfig), get<1>(exportConfig), get<2>(exportConfig));
+        string temporaryPath = _leaderboardPath + ".tmp";
+        ofstream outfile(temporaryPath);
+        if (!outfile) {
+            cout << "Error: " << temporaryPath << " cannot open in write mode." << endl;
+            return;
+        }
+        for (int i = 0; i < (int)best.size() && i < EXPORT_COUNT; i++) {
+            char time[16];
+            snprintf(time, sizeof(time), "%02u:%02u", best[i].seconds / 60 % 100, best[i].seconds % 60);
+            outfile << time << ", " << best[i].name << "\n";
+        }
+        outfile.close();
+
+        error_code error;
+        filesystem::rename(temporaryPath, _leaderboardPath, error);
+        if (error) {
+            cout << "Error: " << _leaderboardPath << " cannot be replaced: " << error.message() << endl;
+        }
+    }
+
+    void writeLoop() {
+        while (true) {
+            vector<Score> batch;
+            vector<Score> kept;
+            bool compact;
+            {
+                unique_lock<mutex> lock(storeMutex);
+                queueReady.wait(lock, [this]() { return stopping || !queue.empty(); });
+                if (queue.empty()) {
+                    break;
+                }
+                batch.swap(queue);
+                compact = keptToCompact(batch.size(), kept);
+            }
+
+            vector<uint8_t> data;
+            for (const Score& score : batch) {
+                encode(score, data);
+            }
+            if (log) {
+                fwrite(data.data(), 1, data.size(), log);
+                sync(log);
+            }
+            logRecords += batch.size();
+            if (compact) {
+                rewriteLog(kept);
+            }
+            exportLeaderboard();
+
+            {
+                lock_guard<mutex> lock(storeMutex);
+                pending -= (int)batch.size();
+            }
+            allWritten.notify_all();
+        }
+
+        if (log) {
+            fclose(log);
+            log = nullptr;
+        }
+    }
+};
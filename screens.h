@@ -2,8 +2,14 @@
 #include <iostream>
 #include <string>
 #include <SFML/Graphics.hpp>
-#include "board.h"
+#include "game.h"
+#include "boardrenderer.h"
+#include "camera.h"
+#include "hud.h"
+#include "replay.h"
+#include "scorestore.h"
 #include "textures.h"
+#include "trace.h"
 #include <cmath>
 #include <chrono>
 #include <fstream>
@@ -25,14 +31,14 @@ public:
     string name = "|";    // Stores the name inputted by the user.
     int _width;
     int _height;
-    sf::Font font;  // The chosen font for the text
+    const sf::Font& font;  // The chosen font for the text, loaded with the textures
     sf::RectangleShape welcomeBackground;
     sf::Text welcomeText;
     sf::Text namePrompt;
     sf::Text userNameField;
 
     // Constructor
-    WelcomeScreen(sf::RenderWindow& window, int width, int height) {
+    WelcomeScreen(sf::RenderWindow&, int width, int height, const Textures& textures) : font(textures.font) {
         _width = width;
         _height = height;
         createWelcomeScreen();
@@ -43,14 +49,6 @@ public:
         // Set background
         setWelcomeBackground(_width, _height, sf::Color::Blue);
 
-        // Get the font from files
-        string filename = "files/font.ttf";
-        if (!font.loadFromFile(filename))
-        {
-            cout << "Font file failed to load." << endl;
-            return 2;
-        }
-
         // Set welcome text
         setWelcomeText(_width, _height);
 
@@ -158,130 +156,116 @@ public:
     bool active = false;
     int _width;
     int _height;
+    int _boardAreaHeight;       // Height of the board area above the HUD
     int _numRows;
     int _numCols;
     int _numMines;
     sf::RectangleShape gameBackground;
-    Board board;
+    Game game;      // The rules and state of the game, independent of the window
+    ScoreStore scoreStore;      // Leaderboard results, written to disk off the UI thread
+    ReplayWriter replay;        // Recording of the current game, saved with its result if it is won
     sf::Sprite happyFaceButton;
     sf::Sprite debugButton;
-    map<string, sf::Texture> gameTextures;
-    bool gameLost = false;
-    bool gameWon = false;
+    const Textures& textures;       // The shared texture atlas
     bool debugMode = false;
     bool isNewGame = true;
     bool leaderboardShownAtEndGame = false;
     bool isTopFive = false;
     int newRank = 100;
 
+    BoardRenderer boardRenderer;    // Draws the board, redrawing only the tiles that changed
+    Camera camera;                  // The part of the board shown above the HUD
+
     // Counter attributes
-    int _flagCounter;
-    vector<sf::Sprite> mineCounterSprites;     // The counter shows number of "mines" (actually flags placed).
-    vector<int> mineCountDigits;        // The digits for the mines
-    sf::Sprite negativeSprite;          // Holds the negative sprite, if it exists.
+    DigitDisplay mineCounter;           // The counter shows number of "mines" (actually flags placed).
 
     // Timer attributes
     bool isPaused = true;
-    vector<sf::Sprite> minutes;         // The minutes digits of the timer
-    vector<sf::Sprite> seconds;         // The seconds digits of the timer
-    vector<int> minutesDigits;
-    vector<int> secondDigits;
+    DigitDisplay minutesDisplay;
+    DigitDisplay secondsDisplay;
+    int timerSeconds = 0;               // Whole seconds the timer shows
     chrono::duration<double> totalDuration;
-    chrono::high_resolution_clock::time_point lastFrameTime;     // Stores the start time of the clock
+    chrono::steady_clock::time_point lastFrameTime;     // Stores the start time of the clock
 
     // Play/Pause Button
     sf::Sprite pauseButton;
 
-    // Pause Board
-    vector<vector<sf::Sprite>> pauseTilesSprites;
-
     // Leaderboard button
     sf::Sprite leaderButton;
 
-    // Construct the game screen (including the board).
-    GameScreen(sf::RenderWindow& window, int width, int height, int numRows, int numCols, int mines, map<string, sf::Texture>& textures) : board(numRows, numCols, mines, textures) {
+    // Trace overlay, showing frames per second and the latency of the last click
+    bool showTrace = false;
+    sf::RectangleShape traceButton;     // Toggles the overlay. It has no image, so it is a labeled box.
+    sf::Text traceButtonLabel;
+    sf::RectangleShape traceBackground;
+    sf::Text traceText;
+
+    // Construct the game screen (including the board). With noGuess set every game can be won without guessing.
+    // Results are saved to the score log and exported to the text leaderboard at the given paths.
+    GameScreen(sf::RenderTarget&, int width, int height, int numRows, int numCols, int mines, const Textures& textures,
+               bool noGuess = false, const string& scoresPath = "files/scores.log",
+               const string& leaderboardPath = "files/leaderboard.txt")
+        : game(numRows, numCols, mines), scoreStore(scoresPath, leaderboardPath, numRows, numCols, game.mines()), textures(textures),
+          camera((float)(numCols * 32), (float)(numRows * 32), width, height - 100, width, height) {
         _width = width;
         _height = height;
+        _boardAreaHeight = height - 100;
         _numRows = numRows;
         _numCols = numCols;
         _numMines = mines;
-        _flagCounter = mines;
-        gameTextures = textures;
-
-        // Offset the sprites by designated amount such that the board is displayed in a grid
-        setAllBaseSpritesPositions(board.baseSprites2D);
-
-        // Initialize a pause board
-        for (int i = 0; i < _numRows; i++) {
-            vector<sf::Sprite> spriteRow;
-            for (int j = 0; j < _numCols; j++) {
-                // Initializes all tiles to hidden.
-                sf::Sprite sprite;
-                sprite.setTexture(gameTextures["tile_revealed"]);
-                spriteRow.push_back(sprite);
-            }
-            pauseTilesSprites.push_back(spriteRow);
-        }
+
+        // Set before the replay starts, since its header records how the mines are placed
+        game.noGuess = noGuess;
+        replay.begin(game);
+
+        boardRenderer.useAtlas(textures);
+        boardRenderer.resize(_numRows, _numCols);
 
         setGameBackground(_width, _height, sf::Color::White);
-        setAllBaseSpritesPositions(pauseTilesSprites);
 
         // Create the Happy Face Button
-        happyFaceButton.setTexture(gameTextures["face_happy"]);
-        happyFaceButton.setPosition((float)((_numCols/2.0) * 32) - 32, (float)(32 * (_numRows + 0.5)));
+        textures.apply(happyFaceButton, TEXTURE_FACE_HAPPY);
+        happyFaceButton.setPosition((float)(_width / 2.0) - 32, (float)(_boardAreaHeight + 16));
 
         // Create the debug button
-        debugButton.setTexture(gameTextures["debug"]);
-        debugButton.setPosition((float)(_numCols * 32) - 304, (float)(_numRows + 0.5) * 32);
-
-        // Create the mine counter
-        // Set the negative sprite
-        negativeSprite.setTexture(gameTextures["digits"]);
-        negativeSprite.setTextureRect(sf::IntRect (10 * 21, 0, 21, 32));
-        negativeSprite.setPosition((float)(12), (float)((_numRows + 0.5) * 32) + 16);
-
-        // Get the digits for the mine count.
-        int tempMineDigits = mines;
-        for (int i = 0; i < 3; i++) {
-            int digit = tempMineDigits % 10;     // Gets the last digit
-            mineCountDigits.insert(mineCountDigits.begin(), digit);     // Inserts into the beginning
-            tempMineDigits /= 10; // Update temp mine digits
-        }
+        textures.apply(debugButton, TEXTURE_DEBUG);
+        debugButton.setPosition((float)_width - 304, (float)(_boardAreaHeight + 16));
 
-        // Set the digit sprites based on the mineCount.
-        int startingPixel = 33;
-        for (int i = 0; i < 3; i++) {
-            sf::Sprite digitsSprite;
-            mineCounterSprites.push_back(digitsSprite);
-            mineCounterSprites[i].setTexture(gameTextures["digits"]);
-            mineCounterSprites[i].setTextureRect(sf::IntRect (mineCountDigits[i] * 21, 0, 21, 32));
-            mineCounterSprites[i].setPosition((float)startingPixel, (float)((_numRows + 0.5) * 32) + 16);
-            startingPixel += 21;    // Each subsequent digit is 21 pixels further to the right.
-        }
+        // Create the mine counter, with the minus sign at the left edge
+        mineCounter.setup(textures, 3, 33, (float)(_boardAreaHeight + 32));
+        mineCounter.show(mines);
 
         // Create the timer with default digits 0
-        for (int i = 0; i < 2; i++) {
-            sf::Sprite minutesDigitSprite;
-            minutes.push_back(minutesDigitSprite);
-            minutes[i].setTexture(gameTextures["digits"]);
-            minutes[i].setPosition((float)((_numCols * 32) - 97 + (i * 21)), (float)((_numRows + 0.5) * 32) + 16);
-            minutes[i].setTextureRect(sf::IntRect (0, 0, 21, 32));
-        }
-        for (int i = 0; i < 2; i++) {
-            sf::Sprite secondDigitsSprite;
-            seconds.push_back(secondDigitsSprite);
-            seconds[i].setTexture(gameTextures["digits"]);
-            seconds[i].setPosition((float)((_numCols * 32) - 54 + (i * 21)), (float)((_numRows + 0.5) * 32) + 16);
-            seconds[i].setTextureRect(sf::IntRect (0, 0, 21, 32));
-        }
+        minutesDisplay.setup(textures, 2, (float)(_width - 97), (float)(_boardAreaHeight + 32));
+        secondsDisplay.setup(textures, 2, (float)(_width - 54), (float)(_boardAreaHeight + 32));
 
         // Create the Pause/Play Button
-        pauseButton.setTexture(gameTextures["pause"]);
-        pauseButton.setPosition((float)(_numCols * 32) - 240, (float)(_numRows + 0.5) * 32);
+        textures.apply(pauseButton, TEXTURE_PAUSE);
+        pauseButton.setPosition((float)_width - 240, (float)(_boardAreaHeight + 16));
 
         // Create the leaderboard button
-        leaderButton.setTexture(gameTextures["leaderboard"]);
-        leaderButton.setPosition((_numCols * 32) - 176, 32 * (_numRows + 0.5));
+        textures.apply(leaderButton, TEXTURE_LEADERBOARD);
+        leaderButton.setPosition((float)_width - 176, (float)(_boardAreaHeight + 16));
+
+        // Create the trace button to the left of the debug button, and the overlay at the top left
+        traceButton.setSize(sf::Vector2f(64, 64));
+        traceButton.setPosition((float)_width - 368, (float)(_boardAreaHeight + 16));
+        traceButton.setFillColor(sf::Color(200, 200, 200));
+        traceButton.setOutlineColor(sf::Color(120, 120, 120));
+        traceButton.setOutlineThickness(-2);
+        traceButtonLabel.setFont(textures.font);
+        traceButtonLabel.setString("FPS");
+        traceButtonLabel.setCharacterSize(18);
+        traceButtonLabel.setFillColor(sf::Color::Black);
+        traceButtonLabel.setStyle(sf::Text::Bold);
+        setText(traceButtonLabel, (float)_width - 336, (float)(_boardAreaHeight + 48));
+        traceBackground.setSize(sf::Vector2f(220, 28));
+        traceBackground.setPosition(4, 4);
+        traceBackground.setFillColor(sf::Color(0, 0, 0, 160));
+        traceText.setFont(textures.font);
+        traceText.setCharacterSize(16);
+        traceText.setFillColor(sf::Color::White);
+        traceText.setPosition(10, 8);
     }
 
     void setGameBackground(int width, int height, sf::Color color) {
@@ -291,59 +275,53 @@ public:
 
     // Gets duration of the game in seconds
     void pause() {
+        if (!isPaused && !game.isOver()) {
+            replay.event(REPLAY_PAUSE, playMilliseconds());
+        }
         isPaused = true;
     }
 
     void unpause() {
+        if (isPaused && !isNewGame && !game.isOver()) {
+            replay.event(REPLAY_RESUME, playMilliseconds());
+        }
         isPaused = false;
-        lastFrameTime = chrono::high_resolution_clock::now();
+        lastFrameTime = chrono::steady_clock::now();
     }
 
-    // Gets the username
-    void drawToScreen(sf::RenderWindow& window) {
+    // Whether the timer is counting, so the screen changes by itself every second
+    bool timerRunning() const {
+        return !isPaused && !isNewGame && !game.isOver();
+    }
+
+    // Milliseconds until the timer shows its next second
+    int millisecondsToNextTick() const {
+        return 1000 - (int)(playMilliseconds() % 1000);
+    }
+
+    // Time played so far in milliseconds, as the timer counts it
+    uint64_t playMilliseconds() const {
+        chrono::duration<double> played = totalDuration;
+        if (!isPaused && !isNewGame) {
+            played += chrono::steady_clock::now() - lastFrameTime;
+        }
+        return (uint64_t)(played.count() * 1000);
+    }
+
+    // Draws the game screen to the window, or to any other target such as an offscreen texture.
+    void drawToScreen(sf::RenderTarget& window) {
+        TraceScope scope("draw_game_screen");
 
         // The default background
         window.draw(gameBackground);
 
-        // As long as the game is not paused, draw the board
-        if (!isPaused || (gameWon || gameLost) || isNewGame) {
-            // Draw all the sprites
-            for (int row = 0; row < _numRows; row++) {
-                for (int col = 0; col < _numCols; col++) {
-                    // Draw base sprites
-                    window.draw(board.baseSprites2D[row][col]);
-                    // Draw any necessary flags
-                    if (board.tiles2D[row][col]->flagged) {
-                        window.draw(board.flagSprites2D[row][col]);
-                    }
-                    // Draw the numbers if they exist
-                    if (board.tiles2D[row][col]->revealed && !board.tiles2D[row][col]->mined && board.tiles2D[row][col]->adjacentMineCount > 0) {
-                        setNumberSpritesPosition(row, col);
-                        window.draw(board.numberSprites2D[row][col]);
-                    }
-                    // If the game is over, draw all mines and change the face button
-                    if (gameLost && board.tiles2D[row][col]->mined) {
-                        setMinesSpritesPosition(row, col);
-                        window.draw(board.mineSprites2D[row][col]);
-                        changeFaceSprite();
-                    }
-                    // If debug mode is on draw the mine sprites.
-                    else if (debugMode && !gameWon && board.tiles2D[row][col]->mined){
-                        setMinesSpritesPosition(row, col);
-                        window.draw(board.mineSprites2D[row][col]);
-                    }
-                }
-            }
-        }
+        // As long as the game is not paused, draw the board.
         // If game is paused, draw a board with all hidden tiles (not the same board)
-        else {
-            for (int row = 0; row < _numRows; row++) {
-                for (int col = 0; col < _numCols; col++) {
-                    // Draw pause board
-                    window.draw(pauseTilesSprites[row][col]);
-                }
-            }
-        }
+        bool showBoard = !isPaused || game.isOver() || isNewGame;
+        boardRenderer.update(game, debugMode, !showBoard);
+        window.setView(camera.view);
+        boardRenderer.draw(window);
+        window.setView(window.getDefaultView());
 
         // Draw the happy face
         window.draw(happyFaceButton);
@@ -352,47 +330,61 @@ public:
         window.draw(debugButton);
 
         // Draw the mine counter
-        for (const auto& digit : mineCounterSprites) {
-            window.draw(digit);
-            if (_flagCounter < 0) {
-                window.draw(negativeSprite);
-            }
-        }
+        mineCounter.draw(window);
 
         if (!isPaused) {
             updateTimer();
         }
 
         // Draw the timer
-        for (const auto& digit : minutes) {
-            window.draw(digit);
-        }
-        for (const auto& digit : seconds) {
-            window.draw(digit);
-        }
+        minutesDisplay.draw(window);
+        secondsDisplay.draw(window);
 
         // Draw the pause button
         window.draw(pauseButton);
 
         // Draw the leaderboard button
         window.draw(leaderButton);
+
+        // Draw the trace button, and the overlay over the board if it is on
+        window.draw(traceButton);
+        window.draw(traceButtonLabel);
+        if (showTrace) {
+            updateTraceText();
+            window.draw(traceBackground);
+            window.draw(traceText);
+        }
+    }
+
+    void toggleTrace() {
+        showTrace = !showTrace;
+    }
+
+    // Shows the frame rate and click latency as of the last frame shown
+    void updateTraceText() {
+        const Tracer& trace = tracer();
+        ostringstream text;
+        text << "FPS " << (int)round(trace.framesPerSecond) << "   click " << fixed;
+        text.precision(1);
+        text << trace.lastInputLatency << " ms";
+        traceText.setString(text.str());
     }
 
     void leftClickAction(int mouseX, int mouseY) {
+        TraceScope scope("left_click");
         // Do an action depending on the location of the click
         updateTimer();      // Ensure the there is actually an elapsed time if the user won on the first click.
 
         // Cannot click if the game is over
-        if (gameLost || gameWon) {
+        if (game.isOver()) {
             return;
         }
 
         // Get index of the tiles
-        int row = mouseY / 32;
-        int col = mouseX / 32;
+        int row, col;
 
         // Left clicks within the tiles
-        if (mouseY < _height - 100) {
+        if (camera.tileAt(mouseX, mouseY, 32, row, col) && game.inBounds(row, col)) {
             // If it's a new game and the game is not paused, it must be the first click. This starts the timer.
             if (isNewGame && isPaused) {
                 unpause();
@@ -403,83 +395,29 @@ public:
                 return;
             }
 
-            // Reveal a hidden tile
-            Tile* tile = board.tiles2D[row][col];
-
-            // Ensure the click was not on a flagged tile
-            if (!tile->flagged) {
-                // End the game if clicked on a mine.
-                if (tile->mined) {
-                    gameLost = true;
-                    revealAllMines();
-                    tile->revealed = true;
-                    pause();
-                }
-                // Reveal tiles as long as they haven't already been revealed.
-                if (!tile->revealed) {
-                    // Otherwise reveal all non-mine tiles if clicked on a tile with no adjacent mines.
-                    if (tile->adjacentMineCount == 0) {
-                        floodFillReveal(row, col);
-                    }
-                    // Otherwise reveal the tile with a mineCount
-                    else if (tile->adjacentMineCount > 0) {
-                        changeBaseSprite("tile_revealed", row, col);
-                        tile->revealed = true;
-                        board.nonMinesRevealed++;
-                    }
-                }
-            }
+            // Reveal the tile, and every tile around it if it has no adjacent mines.
+            floodFillReveal(row, col);
 
             checkForEndGame();
 
         }
     }
 
+    // Updates the screen once the last action lost or won the game.
     void checkForEndGame() {
-        // Check if all non-mine tiles have been revealed and all mine tiles have been flagged
-        // and if so, the game is won.
-//        if ((board.nonMinesRevealed == (_numRows * _numCols) - board._mines) && (board._mines == board.minesFlagged)){
-//            gameWon = true;
-//            changeFaceSprite();
-//            pause();
-//            storeResult(minutesDigits, secondDigits);       // Stores the final result in leaderboards
-//            flagAllMines();
-//        }
-
-        if ((board.nonMinesRevealed == (_numRows * _numCols) - board._mines)){
-            gameWon = true;
+        // Clicking a mine loses the game. The board renderer then shows every mine.
+        if (game.gameLost) {
+            replay.end(game, playMilliseconds());
             changeFaceSprite();
             pause();
-            storeResult(minutesDigits, secondDigits);       // Stores the final result in leaderboards
-            flagAllMines();
-        }
-    }
-
-    // Loops through the board and flags every mine
-    void flagAllMines() {
-        for (int row = 0; row < board.tiles2D.size(); row++) {
-            for (int col = 0; col < board.tiles2D[0].size(); col++) {
-                if (board.tiles2D[row][col]->mined && !board.tiles2D[row][col]->flagged) {
-                    board.tiles2D[row][col]->flagged = true;
-                    sf::Sprite sprite;
-                    sprite.setTexture(gameTextures["flag"]);
-                    board.flagSprites2D[row][col] = sprite;
-                    setFlagSpritePosition(row, col);
-                }
-            }
         }
-    }
-
-    // Change every tile with a mine on it to be revealed. Used at end-game if the user lost.
-    void revealAllMines() {
-        for (int i = 0; i < board.tiles2D.size(); i++) {
-            for (int j = 0; j < board.tiles2D[0].size(); j++) {
-
-                // If the game is lost, reveal that tile if it has a mine on it.
-                if (gameLost && board.tiles2D[i][j] != nullptr && board.tiles2D[i][j]->mined) {
-                    changeBaseSprite("tile_revealed", i, j);
-                }
-            }
+        // The game is won once all non-mine tiles have been revealed. The game flags every mine.
+        else if (game.gameWon) {
+            updateTimer();      // The time on the leaderboard and in the replay is the time of the winning click
+            changeFaceSprite();
+            pause();
+            replay.end(game, playMilliseconds());
+            storeResult(timerSeconds);       // Stores the final result in leaderboards
         }
     }
 
@@ -493,117 +431,65 @@ public:
     }
 
 
-    // Recursively reveals all empty tiles when clicking on one.
+    // Reveals the clicked tile and the opening around it. The board renderer picks up the change on the next frame.
     void floodFillReveal(int row, int col) {
-        // Ensure the row or column is within the bounds of the board
-        int maxRow = board.tiles2D.size() - 1;
-        int maxCol = board.tiles2D[0].size() - 1;
-        if (row < 0 || row > maxRow || col < 0 || col > maxCol) {
-            return;
-        }
-        // Stop if the tile is already revealed
-        Tile* tile = board.tiles2D[row][col];
-        if (tile->mined || tile->revealed) return;
-
-        // Check the tile is adjacent to an empty tile.
-        bool hasEmptyAdjacent = false;
-        for (auto & adjacentTile : tile->adjacentTiles) {
-            if (adjacentTile != nullptr && adjacentTile->adjacentMineCount == 0) {
-                hasEmptyAdjacent = true;
-                break;
-            }
+        TraceScope scope("flood_fill_reveal");
+        if (game.inBounds(row, col)) {
+            replay.tileEvent(REPLAY_REVEAL, row, col, playMilliseconds());
         }
+        game.reveal(row, col);
+    }
 
-        if (!tile->flagged && !tile->revealed && (hasEmptyAdjacent || tile->adjacentMineCount == 0)) {
-            changeBaseSprite("tile_revealed", row, col);
-            tile->revealed = true;
-            board.nonMinesRevealed++;
-        }
-        // Then return if the tile had a number
-        if (tile->flagged || tile->adjacentMineCount > 0) {
+    // Reveals the unflagged neighbors of a satisfied number.
+    void middleClickAction(int mouseX, int mouseY) {
+        // Cannot click if the game is over or paused
+        if (game.isOver() || isPaused) {
             return;
         }
 
-        floodFillReveal(row + 1, col);  // Move down
-        floodFillReveal(row - 1, col);  // Move up
-        floodFillReveal(row, col + 1);  // Move right
-        floodFillReveal(row, col - 1);  // Move left
-        floodFillReveal(row + 1, col + 1); // Move bottom-right
-        floodFillReveal(row - 1, col + 1);  // Move top-right
-        floodFillReveal(row - 1, col - 1); // Move top-left
-        floodFillReveal(row + 1, col - 1); // Move bottom-left
+        int row, col;
+        if (camera.tileAt(mouseX, mouseY, 32, row, col) && game.inBounds(row, col)) {
+            replay.tileEvent(REPLAY_CHORD, row, col, playMilliseconds());
+            game.chord(row, col);
+            checkForEndGame();
+        }
     }
 
     // Does an action depending on where right-clicking
     void rightClickAction(int mouseX, int mouseY) {
 
         // Cannot click if the game is over or paused
-        if (gameLost || gameWon || isPaused) {
+        if (game.isOver() || isPaused) {
             return;
         }
 
         // Get index of the tiles
-        int row = mouseY / 32;
-        int col = mouseX / 32;
-
-        // Right clicks within the tiles
-        if (mouseY < _height - 100) {
-            // Flag or unflag a tile
-            Tile* tile = board.tiles2D[row][col];
-            if (!tile->revealed) {
-                sf::Sprite sprite;
-                if (!tile->flagged) {
-                    tile->flagged = true;
-                    _flagCounter--;
-                    updateMineCounter();
-                    sprite.setTexture(gameTextures["flag"]);
-                    if (tile->mined) {
-                        board.minesFlagged++;
-                    }
-                }
-                else if (tile->flagged) {
-                    tile->flagged = false;
-                    _flagCounter++;
-                    updateMineCounter();
-                    if (tile->mined) {
-                        board.minesFlagged--;
-                    }
-                }
-                // Update sprite
-                board.flagSprites2D[row][col] = sprite;
-                setFlagSpritePosition(row, col);
-            }
-        }
-
-        checkForEndGame();
-    }
+        int row, col;
 
-    // Changes the tile that was clicked on to the given texture, if possible.
-    void changeBaseSprite(string textureName, int row, int col) {
-        // Stores the new sprite at that index in the board
-        sf::Sprite sprite;
-        sprite.setTexture(gameTextures[textureName]);
-        board.baseSprites2D[row][col] = sprite;
-        setBaseSpritePosition(row, col);
+        // Right clicks within the tiles flag or unflag a hidden tile
+        if (camera.tileAt(mouseX, mouseY, 32, row, col) && game.toggleFlag(row, col)) {
+            replay.tileEvent(REPLAY_FLAG, row, col, playMilliseconds());
+            updateMineCounter();
+        }
     }
 
     // Changes the face depending on win/loss
     void changeFaceSprite() {
-        if (gameLost) {
-            happyFaceButton.setTexture(gameTextures["face_lose"]);
+        if (game.gameLost) {
+            textures.apply(happyFaceButton, TEXTURE_FACE_LOSE);
         }
-        else if (gameWon) {
-            happyFaceButton.setTexture(gameTextures["face_win"]);
+        else if (game.gameWon) {
+            textures.apply(happyFaceButton, TEXTURE_FACE_WIN);
         }
         else {
-            happyFaceButton.setTexture(gameTextures["face_happy"]);
+            textures.apply(happyFaceButton, TEXTURE_FACE_HAPPY);
         }
     }
 
     // Switches between pause/play
     void togglePause() {
         // Cannot toggle when the game is over.
-        if (gameLost || gameWon) {
+        if (game.isOver()) {
             return;
         }
         else if (isPaused) {
@@ -619,10 +505,10 @@ public:
     // Change the pause button sprite depending on current state.
     void changePauseSprite() {
         if (isPaused) {
-            pauseButton.setTexture(gameTextures["play"]);
+            textures.apply(pauseButton, TEXTURE_PLAY);
         }
         else {
-            pauseButton.setTexture(gameTextures["pause"]);
+            textures.apply(pauseButton, TEXTURE_PAUSE);
         }
     }
 
@@ -633,100 +519,19 @@ public:
         }
         // Updates the timer if active and not paused.
         else {
-            auto now = chrono::high_resolution_clock::now();
+            auto now = chrono::steady_clock::now();
             totalDuration = totalDuration + now - lastFrameTime;
             lastFrameTime = now;
         }
 
-        // Start with fresh vectors
-        minutes.clear();
-        seconds.clear();
-
-        // Get the digits for the seconds and minutes.
-        int numMin = (int)floor(totalDuration.count()) / 60;    // Gets number of minutes elapsed
-        int numSec = (int)floor(totalDuration.count()) % 60;    // Gets number of seconds elapsed
-
-        // Get the digits for the minutes and seconds
-        int tempMinuteDigits = numMin;
-        int tempSecondsDigits = numSec;
-        for (int i = 0; i < 2; i++) {
-            int minDigit = tempMinuteDigits % 10;     // Gets the last digit of minutes
-            minutesDigits.insert(minutesDigits.begin(), minDigit);     // Inserts into the beginning
-            tempMinuteDigits /= 10; // Update temp mine digits
-
-            int secDigit = tempSecondsDigits % 10;     // Gets the last digit of seconds
-            secondDigits.insert(secondDigits.begin(), secDigit);     // Inserts into the beginning
-            tempSecondsDigits /= 10;
-        }
-
-        // Set the digit sprites based on the minutes and seconds.
-        for (int i = 0; i < 2; i++) {
-            sf::Sprite minutesDigitSprite;
-            minutes.push_back(minutesDigitSprite);
-            minutes[i].setTexture(gameTextures["digits"]);
-            minutes[i].setPosition((float)((_numCols * 32) - 97 + (i * 21)), (float)((_numRows + 0.5) * 32) + 16);
-            minutes[i].setTextureRect(sf::IntRect (minutesDigits[i] * 21, 0, 21, 32));
-        }
-        for (int i = 0; i < 2; i++) {
-            sf::Sprite secondDigitsSprite;
-            seconds.push_back(secondDigitsSprite);
-            seconds[i].setTexture(gameTextures["digits"]);
-            seconds[i].setPosition((float)((_numCols * 32) - 54 + (i * 21)), (float)((_numRows + 0.5) * 32) + 16);
-            seconds[i].setTextureRect(sf::IntRect (secondDigits[i] * 21, 0, 21, 32));
-        }
+        // Only the digits that changed get new texture rects
+        timerSeconds = (int)floor(totalDuration.count());
+        minutesDisplay.show(timerSeconds / 60 % 100);
+        secondsDisplay.show(timerSeconds % 60);
     }
 
-    // Update mineCounterSprites;
     void updateMineCounter() {
-
-        // Start with fresh vectors
-        mineCounterSprites.clear();
-        mineCountDigits.clear();
-
-        // Get the digits for the mine count.
-        int tempMineDigits = _flagCounter;
-        for (int i = 0; i < 3; i++) {
-            int digit = tempMineDigits % 10;     // Gets the last digit
-            mineCountDigits.insert(mineCountDigits.begin(), digit);     // Inserts into the beginning
-            tempMineDigits /= 10; // Update temp mine digits
-        }
-
-        // Set the digit sprites based on the mineCount.
-        // Store the rest of the digits
-        int startingPixel = 33;
-        for (int i = 0; i < 3; i++) {
-            sf::Sprite digitsSprite;
-            mineCounterSprites.push_back(digitsSprite);
-            mineCounterSprites[i].setTexture(gameTextures["digits"]);
-            mineCounterSprites[i].setTextureRect(sf::IntRect (abs(mineCountDigits[i]) * 21, 0, 21, 32));
-            mineCounterSprites[i].setPosition((float)startingPixel, (float)((_numRows + 0.5) * 32) + 16);
-            startingPixel += 21;    // Each subsequent digit is 21 pixels further to the right.
-        }
-
-    }
-
-    void setAllBaseSpritesPositions(vector<vector<sf::Sprite>>& tiles) const {
-        for (int row = 0; row < _numRows; row++) {
-            for (int col = 0; col < _numCols; col++) {
-                tiles[row][col].setPosition((float)(32 * col), (float)(32 * row));
-            }
-        }
-    }
-
-    void setBaseSpritePosition(int row, int col) {
-        board.baseSprites2D[row][col].setPosition((float)(32 * col), (float)(32 * row));
-    }
-
-    void setFlagSpritePosition(int row, int col) {
-        board.flagSprites2D[row][col].setPosition((float)(32 * col), (float)(32 * row));
-    }
-
-    void setMinesSpritesPosition(int row, int col) {
-        board.mineSprites2D[row][col].setPosition((float)(32 * col), (float)(32 * row));
-    }
-
-    void setNumberSpritesPosition(int row, int col) {
-        board.numberSprites2D[row][col].setPosition((float)(32 * col), (float)(32 * row));
+        mineCounter.show(game.flagCounter);
     }
 
     void activate() {
@@ -737,83 +542,34 @@ public:
         active = false;
     }
 
-    void storeResult(vector<int> finalMinutes, vector<int> finalSeconds) {
-        // Opens file in read mode
-        ifstream infile("files/leaderboard.txt");
-        if (!infile) {
-            cout << "Error: leaderboard.txt cannot open in read mode." << endl;
-        }
-
-        // Store all the previous scores, temporarily because the file will be overwritten
-        vector<string> oldRecords;
-        string line;
-        while (getline(infile, line)) {
-            oldRecords.push_back(line);
-        }
-        infile.close();
-        
-        // From the temporarily stored scores, get only the score part
-        vector<string> oldScores;
-        for (const string& record : oldRecords) {
-            oldScores.push_back(record.substr(0, 5));
-        }
+    // Records the win. The store updates its in-memory leaderboard at once and writes to disk on its own thread.
+    void storeResult(int finalSeconds) {
+        TraceScope scope("store_result");
+        Score score;
+        score.rows = _numRows;
+        score.cols = _numCols;
+        score.mines = game.mines();     // As recorded in the replay, after the board clamped it
+        score.seconds = (uint32_t)finalSeconds;
+        score.name = name.substr(0, name.size() - 1);       // Ignore the pipe '|' symbol.
+        score.replay = replay.data;
 
-        // Create the new score to be stored
-        // Convert time to string form
-        ostringstream stream;
-        stream << finalMinutes[0];
-        stream << finalMinutes[1] << ":";
-        stream << finalSeconds[0];
-        stream << finalSeconds[1];
-        string finalTime = stream.str();
-        string newName = name.substr(0, name.size() - 1);       // Ignore the pipe '|' symbol.
-        string newRecord = finalTime + ", " + newName;       // The new score that will be stored on the leaderboard
-
-
-        // Store the current score in the right location
-        for (int i = 0; i < oldScores.size(); i++) {
-            // If the records match one that already exists, return to avoid duplication.
-            if (newRecord == oldRecords[i]) {
-                return;
-            }
-
-            if ((finalTime <= oldScores[i]) && i <= 5) {
-                // Insert into the index
-                oldRecords.insert(oldRecords.begin() + i, newRecord);
-                isTopFive = true;
-                newRank = i;
-                break;
-            }
-        }
-
-        // Write back the top 5 scores
-        ofstream outfile("files/leaderboard.txt");
-        if (!outfile) {
-            cout << "Error: leaderboard.txt cannot open in write mode." << endl;
-        }
-        for (int i = 0; i < oldRecords.size(); i++) {
-          // Only store top 5
-          if (i > 4) {
-              break;
-          }
-          outfile << oldRecords[i] << "\n";
+        int rank = scoreStore.add(score);
+        if (rank >= 0 && rank < ScoreStore::EXPORT_COUNT) {
+            isTopFive = true;
+            newRank = rank;
         }
-        outfile.close();
     }
 
     void reset() {
-        gameLost = false;
-        gameWon = false;
         isNewGame = true;
         isPaused = true;
         isTopFive = false;
         newRank = 100;
         leaderboardShownAtEndGame = false;
 
-        // Recreate the tiles
-        board.eraseTiles();
-        board = Board(_numRows, _numCols, _numMines, gameTextures);
-        setAllBaseSpritesPositions(board.baseSprites2D);
+        // Start a new game
+        game.reset();
+        replay.begin(game);
 
         // Reset the face button
         changeFaceSprite();
@@ -824,7 +580,6 @@ public:
         }
 
         // Resets the mine counter
-        _flagCounter = _numMines;
         updateMineCounter();
 
         // Reset the timer
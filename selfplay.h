@@ -0,0 +1,335 @@
+#pragma once
+#include "game.h"
+#include "probability.h"
+#include "rng.h"
+#include "solver.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Bots playing the game through the Game class, the same moves a left click, right click or chord makes
+// on the game screen, and a harness that plays many seeded games with them on every core.
+
+enum MoveKind {MOVE_REVEAL, MOVE_FLAG, MOVE_CHORD, MOVE_RESIGN};
+
+struct Move {
+    MoveKind kind = MOVE_RESIGN;
+    int row = 0;
+    int col = 0;
+};
+
+// A bot. The harness gives each thread its own strategy, so a strategy keeps whatever state it likes
+// without locking. Any randomness must come from the seed given to startGame, which keeps a game's result
+// the same for any number of threads.
+class Strategy {
+public:
+    virtual ~Strategy() = default;
+
+    // A new game starts with no mines placed. seed is for the strategy's own choices, not the board.
+    virtual void startGame(const Game& game, uint64_t seed) = 0;
+
+    // The next move. Resigning, or a move that changes nothing, ends the game as a loss.
+    virtual Move nextMove(const Game& game) = 0;
+
+    // Called after each move is played, with the tiles it revealed in game.lastRevealed()
+    virtual void movePlayed(const Game&, const Move&) {}
+};
+
+// Reveals a random hidden, unflagged tile every move
+class RandomStrategy : public Strategy {
+public:
+    void startGame(const Game&, uint64_t seed) override {
+        rng = Rng(seed);
+    }
+
+    Move nextMove(const Game& game) override {
+        // Tries random tiles first, as most are hidden for most of the game, then falls back to a scan
+        for (int attempt = 0; attempt < 64; attempt++) {
+            int row = (int)rng.below((uint64_t)game.rows());
+            int col = (int)rng.below((uint64_t)game.cols());
+            if (isCandidate(game, row, col)) {
+                return {MOVE_REVEAL, row, col};
+            }
+        }
+        candidates.clear();
+        for (int row = 0; row < game.rows(); row++) {
+            for (int col = 0; col < game.cols(); col++) {
+                if (isCandidate(game, row, col)) {
+                    candidates.push_back(row * game.cols() + col);
+                }
+            }
+        }
+        if (candidates.empty()) {
+            return {};
+        }
+        int position = candidates[rng.below(candidates.size())];
+        return {MOVE_REVEAL, position / game.cols(), position % game.cols()};
+    }
+
+private:
+    Rng rng{0};
+    vector<int> candidates;
+
+    static bool isCandidate(const Game& game, int row, int col) {
+        const Tile& tile = game.tileAt(row, col);
+        return !tile.isRevealed() && !tile.isFlagged();
+    }
+};
+
+// Opens in the middle, reveals every tile the solver deduces safe, flags the mines it deduces, and guesses
+// a random undecided tile when nothing is certain
+class SolverStrategy : public Strategy {
+public:
+    void startGame(const Game& game, uint64_t seed) override {
+        rng = Rng(seed);
+        solver.reset(game.board);
+        safeTaken = 0;
+        minesTaken = 0;
+        opened = false;
+    }
+
+    Move nextMove(const Game& game) override {
+        if (!opened) {
+            opened = true;
+            return {MOVE_REVEAL, game.rows() / 2, game.cols() / 2};
+        }
+        const Board& board = game.board;
+        while (safeTaken < solver.safeTiles.size()) {
+            int index = solver.safeTiles[safeTaken++];
+            if (!board.tiles[index].isRevealed()) {
+                return {MOVE_REVEAL, board.rowOf(index), board.colOf(index)};
+            }
+        }
+        while (minesTaken < solver.mineTiles.size()) {
+            int index = solver.mineTiles[minesTaken++];
+            if (!board.tiles[index].isFlagged()) {
+                return {MOVE_FLAG, board.rowOf(index), board.colOf(index)};
+            }
+        }
+        return guess(game);
+    }
+
+    void movePlayed(const Game& game, const Move& move) override {
+        if (move.kind == MOVE_FLAG) {
+            solver.notifyFlagChanged(game.board.index(move.row, move.col));
+        }
+        else {
+            solver.notifyRevealed(game.lastRevealed());
+        }
+        solver.solve();
+    }
+
+protected:
+    Solver solver;
+    Rng rng{0};
+    size_t safeTaken = 0;       // Deductions already played
+    size_t minesTaken = 0;
+    bool opened = false;
+    vector<int> undecided;
+
+    virtual Move guess(const Game& game) {
+        const Board& board = game.board;
+        undecided.clear();
+        for (int row = 0; row < game.rows(); row++) {
+            for (int col = 0; col < game.cols(); col++) {
+                int index = board.index(row, col);
+                if (!board.tiles[index].isRevealed() && !board.tiles[index].isFlagged()
+                    && solver.known[index] == Solver::UNKNOWN) {
+                    undecided.push_back(index);
+                }
+            }
+        }
+        if (undecided.empty()) {
+            return {};
+        }
+        int index = undecided[rng.below(undecided.size())];
+        return {MOVE_REVEAL, board.rowOf(index), board.colOf(index)};
+    }
+};
+
+// The solver's moves, guessing the tile with the lowest exact mine probability when nothing is certain.
+// Every mine the solver found is flagged by then, so the probability engine sees them.
+class ProbabilityStrategy : public SolverStrategy {
+public:
+    // One thread per engine: the harness already runs a game on every core
+    ProbabilityStrategy() : engine(1) {}
+
+protected:
+    ProbabilityEngine engine;
+
+    Move guess(const Game& game) override {
+        const Board& board = game.board;
+        if (!engine.compute(board)) {
+            return SolverStrategy::guess(game);
+        }
+        int best = -1;
+        double safest = 2.0;
+        for (int row = 0; row < game.rows(); row++) {
+            for (int col = 0; col < game.cols(); col++) {
+                int index = board.index(row, col);
+                const Tile& tile = board.tiles[index];
+                if (!tile.isRevealed() && !tile.isFlagged() && engine.probability[index] < safest) {
+                    safest = engine.probability[index];
+                    best = index;
+                }
+            }
+        }
+        if (best < 0) {
+            return {};
+        }
+        return {MOVE_REVEAL, board.rowOf(best), board.colOf(best)};
+    }
+};
+
+// A strategy by name: "random", "solver" or "probability". Null for any other name.
+inline unique_ptr<Strategy> makeStrategy(const string& name) {
+    if (name == "random") {
+        return make_unique<RandomStrategy>();
+    }
+    else if (name == "solver") {
+        return make_unique<SolverStrategy>();
+    }
+    else if (name == "probability") {
+        return make_unique<ProbabilityStrategy>();
+    }
+    return nullptr;
+}
+
+struct SelfPlayResult {
+    long long games = 0;
+    long long wins = 0;
+    long long clicks = 0;       // Moves that changed the game, as clicks on the game screen would
+    double seconds = 0;
+
+    double winRate() const {
+        return games > 0 ? (double)wins / games : 0.0;
+    }
+
+    double clicksPerGame() const {
+        return games > 0 ? (double)clicks / games : 0.0;
+    }
+
+    double gamesPerSecond() const {
+        return seconds > 0 ? games / seconds : 0.0;
+    }
+};
+
+// Wilson score interval of a win rate; z = 1.96 gives 95% confidence. Unlike the normal approximation it
+// stays inside [0, 1] and is sensible for win rates near 0 or 1.
+inline void wilsonInterval(long long wins, long long games, double& low, double& high, double z = 1.96) {
+    if (games <= 0) {
+        low = 0;
+        high = 1;
+        return;
+    }
+    double n = (double)games;
+    double p = (double)wins / n;
+    double denominator = 1 + z * z / n;
+    double center = (p + z * z / (2 * n)) / denominator;
+    double margin = z * sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / denominator;
+    low = max(0.0, center - margin);
+    high = min(1.0, center + margin);
+}
+
+// Plays games on a number of threads, each with its own game and strategy. Game i is placed from
+// Rng::stream(seed, i) and the strategy is seeded from another stream, so every game is reproducible and the
+// totals do not depend on the number of threads. Threads take games in chunks from one atomic counter and
+// count their results locally, so they share nothing else while playing.
+class SelfPlay {
+public:
+    static const int CHUNK_GAMES = 64;      // Games a thread takes at once
+
+    int rows;
+    int cols;
+    int mines;
+    uint64_t seed;
+    int maxMoves;           // Moves after which a game counts as lost, so a stuck strategy cannot hang a thread
+
+    SelfPlay(int boardRows, int boardCols, int boardMines, uint64_t gameSeed)
+        : rows(boardRows), cols(boardCols), mines(boardMines), seed(gameSeed), maxMoves(4 * boardRows * boardCols + 16) {}
+
+    SelfPlayResult run(const function<unique_ptr<Strategy>()>& newStrategy, long long games, int threads) {
+        threads = max(threads, 1);
+        vector<PaddedResult> results(threads);
+        atomic<long long> nextGame{0};
+
+        auto start = chrono::steady_clock::now();
+        vector<thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([this, &newStrategy, &results, &nextGame, games, t]() {
+                unique_ptr<Strategy> strategy = newStrategy();
+                Game game(rows, cols, mines, seed);
+                game.trackChanges = false;
+                SelfPlayResult& result = results[t].result;
+                while (true) {
+                    long long first = nextGame.fetch_add(CHUNK_GAMES, memory_order_relaxed);
+                    if (first >= games) {
+                        break;
+                    }
+                    long long last = min(games, first + CHUNK_GAMES);
+                    for (long long i = first; i < last; i++) {
+                        play(game, *strategy, (uint64_t)i, result);
+                    }
+                }
+            });
+        }
+        for (thread& worker : workers) {
+            worker.join();
+        }
+
+        SelfPlayResult total;
+        for (const PaddedResult& padded : results) {
+            total.games += padded.result.games;
+            total.wins += padded.result.wins;
+            total.clicks += padded.result.clicks;
+        }
+        total.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return total;
+    }
+
+private:
+    // Each thread's counts on their own cache line
+    struct alignas(64) PaddedResult {
+        SelfPlayResult result;
+    };
+
+    void play(Game& game, Strategy& strategy, uint64_t gameIndex, SelfPlayResult& result) const {
+        game.reset(Rng::stream(seed, gameIndex));
+        strategy.startGame(game, Rng::stream(~seed, gameIndex));
+        for (int moves = 0; moves < maxMoves && !game.isOver(); moves++) {
+            Move move = strategy.nextMove(game);
+            if (!apply(game, move)) {
+                break;
+            }
+            result.clicks++;
+            strategy.movePlayed(game, move);
+        }
+        result.games++;
+        result.wins += game.gameWon;
+    }
+
+    // Plays a move. Returns false if it changed nothing.
+    static bool apply(Game& game, const Move& move) {
+        if (move.kind == MOVE_REVEAL) {
+            bool wasRevealed = game.inBounds(move.row, move.col) && game.tileAt(move.row, move.col).isRevealed();
+            game.reveal(move.row, move.col);
+            return !wasRevealed && (game.gameLost || !game.lastRevealed().empty());
+        }
+        else if (move.kind == MOVE_FLAG) {
+            return game.toggleFlag(move.row, move.col);
+        }
+        else if (move.kind == MOVE_CHORD) {
+            game.chord(move.row, move.col);
+            return game.gameLost || !game.lastRevealed().empty();
+        }
+        return false;
+    }
+};
@@ -0,0 +1,639 @@
+#pragma once
+#include "game.h"
+#include "rng.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Headless game server: many independent games (sessions) in one process, played over a local socket.
+// Connections are spread over a fixed set of worker threads, each running a poll loop over its own
+// connections, and a request is handled on the worker that read it. Sessions live in a table split into
+// shards with a lock each, so any worker can play any session and a connection can play many sessions.
+// POSIX sockets only: a Unix socket ("unix:/path") or TCP on the loopback interface ("port" or "host:port").
+//
+// Protocol (little-endian). Every message is a uint32 length of the rest of the message, then the rest.
+// Request:  uint8 type, uint64 session, then by type:
+//   SERVER_NEW_GAME  uint32 rows, uint32 cols, uint32 mines, uint64 seed (0 for a random one).
+//                    Session 0 creates a session; any other session starts a new game in place.
+//   SERVER_REVEAL, SERVER_FLAG, SERVER_CHORD  uint32 row, uint32 col
+//   SERVER_DIFF, SERVER_CLOSE  nothing
+// Response: uint8 status, uint8 request type, then if the status is SERVER_OK, by type:
+//   SERVER_NEW_GAME  uint64 session, uint32 rows, uint32 cols, uint32 mines
+//   SERVER_REVEAL, SERVER_FLAG, SERVER_CHORD  uint8 outcome, uint32 tiles changed
+//   SERVER_DIFF  uint8 outcome, int32 flag counter, uint32 count, then count tiles of uint32 row * cols + col
+//                and uint8 look, for every tile that changed since the last diff (all tiles after a new game)
+//   SERVER_CLOSE  nothing
+// Outcomes are 0 playing, 1 won and 2 lost. Looks are 0-8 for a revealed number, then SERVER_HIDDEN,
+// SERVER_FLAGGED and SERVER_MINE; mines are only shown once revealed or the game is lost.
+// A connection is not read while SERVER_MAX_PENDING_OUTPUT bytes of responses wait for it to read them, so a
+// client that sends requests without reading the responses holds at most that much, plus one response.
+
+enum ServerRequest {
+    SERVER_NEW_GAME = 1,
+    SERVER_REVEAL,
+    SERVER_FLAG,
+    SERVER_CHORD,
+    SERVER_DIFF,
+    SERVER_CLOSE
+};
+
+enum ServerStatus {
+    SERVER_OK,
+    SERVER_UNKNOWN_SESSION,
+    SERVER_BAD_REQUEST,
+    SERVER_TOO_MANY_SESSIONS
+};
+
+enum ServerLook {
+    SERVER_HIDDEN = 9,
+    SERVER_FLAGGED,
+    SERVER_MINE
+};
+
+const uint32_t SERVER_MAX_REQUEST = 64;         // Longer requests close the connection
+const size_t SERVER_MAX_PENDING_OUTPUT = 1 << 20;   // Unsent response bytes above which a connection is not read
+const int SERVER_MAX_TILES = 1 << 20;           // Largest board a session can have
+
+// Appends little-endian values to a message
+inline void putU8(vector<uint8_t>& out, uint8_t value) {
+    out.push_back(value);
+}
+
+inline void putU32(vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back((uint8_t)(value >> (8 * i)));
+    }
+}
+
+inline void putU64(vector<uint8_t>& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out.push_back((uint8_t)(value >> (8 * i)));
+    }
+}
+
+inline uint32_t getU32(const uint8_t* in) {
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+inline uint64_t getU64(const uint8_t* in) {
+    return (uint64_t)getU32(in) | (uint64_t)getU32(in + 4) << 32;
+}
+
+// Starts a message whose length is filled in by endMessage
+inline size_t beginMessage(vector<uint8_t>& out) {
+    size_t start = out.size();
+    putU32(out, 0);
+    return start;
+}
+
+inline void endMessage(vector<uint8_t>& out, size_t start) {
+    uint32_t length = (uint32_t)(out.size() - start - 4);
+    for (int i = 0; i < 4; i++) {
+        out[start + i] = (uint8_t)(length >> (8 * i));
+    }
+}
+
+// Opens a socket for an address as described above, listening or connected. Returns -1 on failure.
+inline int openSocket(const string& address, bool listening) {
+    int fd;
+    if (address.rfind("unix:", 0) == 0) {
+        sockaddr_un local{};
+        local.sun_family = AF_UNIX;
+        string path = address.substr(5);
+        if (path.size() >= sizeof(local.sun_path)) {
+            return -1;
+        }
+        memcpy(local.sun_path, path.c_str(), path.size() + 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (listening) {
+            unlink(path.c_str());
+        }
+        int result = listening ? ::bind(fd, (sockaddr*)&local, sizeof(local)) : connect(fd, (sockaddr*)&local, sizeof(local));
+        if (result != 0 || (listening && listen(fd, 512) != 0)) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    size_t colon = address.rfind(':');
+    string host = colon == string::npos ? "127.0.0.1" : address.substr(0, colon);
+    sockaddr_in inet{};
+    inet.sin_family = AF_INET;
+    inet.sin_port = htons((uint16_t)stoi(colon == string::npos ? address : address.substr(colon + 1)));
+    if (inet_pton(AF_INET, host.c_str(), &inet.sin_addr) != 1) {
+        return -1;
+    }
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    if (listening) {
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    }
+    int result = listening ? ::bind(fd, (sockaddr*)&inet, sizeof(inet)) : connect(fd, (sockaddr*)&inet, sizeof(inet));
+    if (result != 0 || (listening && listen(fd, 512) != 0)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// One player's game and when it was last played
+struct Session {
+    Game game;
+    chrono::steady_clock::time_point lastUsed;
+
+    Session(int rows, int cols, int mines, uint64_t seed) : game(rows, cols, mines, seed) {}
+};
+
+class GameServer {
+public:
+    static const int SHARDS = 64;
+    static const int IDLE_MINUTES = 30;         // Sessions not played for this long are closed
+
+    int maxSessions;
+    atomic<int> sessionCount{0};
+    atomic<long long> requestCount{0};
+
+    GameServer(int workerCount = (int)thread::hardware_concurrency(), int maxSessions = 100000)
+        : maxSessions(maxSessions) {
+        workerCount = max(workerCount, 1);
+        for (int i = 0; i < workerCount; i++) {
+            workers.push_back(make_unique<Worker>());
+        }
+    }
+
+    ~GameServer() {
+        stop();
+    }
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    // Listens on the address and starts the workers. Returns false if the address cannot be listened on.
+    bool start(const string& address) {
+        listenFd = openSocket(address, true);
+        if (listenFd < 0) {
+            return false;
+        }
+        for (auto& worker : workers) {
+            if (pipe(worker->wakeFds) != 0) {
+                return false;
+            }
+            fcntl(worker->wakeFds[0], F_SETFL, O_NONBLOCK);
+            fcntl(worker->wakeFds[1], F_SETFL, O_NONBLOCK);
+        }
+        running = true;
+        for (size_t i = 0; i < workers.size(); i++) {
+            workers[i]->loop = thread([this, i]() { work(*workers[i], (uint64_t)i); });
+        }
+        return true;
+    }
+
+    // Accepts connections and hands them to the workers in turn until stop is called or shouldStop returns
+    // true, checked a few times a second. Also closes idle sessions.
+    template <typename StopCheck>
+    void run(StopCheck shouldStop) {
+        size_t nextWorker = 0;
+        auto lastSweep = chrono::steady_clock::now();
+        while (running && !shouldStop()) {
+            pollfd listener = {listenFd, POLLIN, 0};
+            if (poll(&listener, 1, 200) > 0) {
+                int fd = accept(listenFd, nullptr, nullptr);
+                if (fd >= 0) {
+                    fcntl(fd, F_SETFL, O_NONBLOCK);
+                    int on = 1;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                    Worker& worker = *workers[nextWorker++ % workers.size()];
+                    {
+                        lock_guard<mutex> lock(worker.newMutex);
+                        worker.newConnections.push_back(fd);
+                    }
+                    wake(worker);
+                }
+            }
+            if (chrono::steady_clock::now() - lastSweep > chrono::seconds(10)) {
+                closeIdleSessions();
+                lastSweep = chrono::steady_clock::now();
+            }
+        }
+        stop();
+    }
+
+    void stop() {
+        if (!running.exchange(false)) {
+            return;
+        }
+        for (auto& worker : workers) {
+            wake(*worker);
+        }
+        for (auto& worker : workers) {
+            worker->loop.join();
+            close(worker->wakeFds[0]);
+            close(worker->wakeFds[1]);
+        }
+        close(listenFd);
+        listenFd = -1;
+    }
+
+private:
+    struct Connection {
+        int fd;
+        vector<uint8_t> input;
+        vector<uint8_t> output;
+        size_t outputSent = 0;
+
+        size_t pendingOutput() const {
+            return output.size() - outputSent;
+        }
+    };
+
+    struct Worker {
+        thread loop;
+        int wakeFds[2] = {-1, -1};
+        mutex newMutex;
+        vector<int> newConnections;     // Accepted connections not yet picked up by the worker
+    };
+
+    struct Shard {
+        mutex lock;
+        unordered_map<uint64_t, unique_ptr<Session>> sessions;
+    };
+
+    vector<unique_ptr<Worker>> workers;
+    Shard shards[SHARDS];
+    atomic<uint64_t> nextSessionId{1};
+    atomic<bool> running{false};
+    int listenFd = -1;
+
+    void wake(Worker& worker) {
+        char byte = 0;
+        if (write(worker.wakeFds[1], &byte, 1) < 0) {
+            // The pipe is full, so the worker is already awake
+        }
+    }
+
+    void work(Worker& worker, uint64_t workerIndex) {
+        vector<Connection> connections;
+        vector<pollfd> polled;
+        Rng seeds(Rng::stream(newSeed(), workerIndex));
+        uint8_t buffer[65536];
+
+        while (running) {
+            polled.clear();
+            polled.push_back({worker.wakeFds[0], POLLIN, 0});
+            for (const Connection& connection : connections) {
+                // Reading pauses while too many responses are unsent, and resumes once the client reads them
+                short events = connection.pendingOutput() < SERVER_MAX_PENDING_OUTPUT ? POLLIN : 0;
+                if (connection.pendingOutput() > 0) {
+                    events |= POLLOUT;
+                }
+                polled.push_back({connection.fd, events, 0});
+            }
+            if (poll(polled.data(), (nfds_t)polled.size(), -1) < 0) {
+                continue;
+            }
+
+            if (polled[0].revents & POLLIN) {
+                while (read(worker.wakeFds[0], buffer, sizeof(buffer)) > 0) {
+                }
+                lock_guard<mutex> lock(worker.newMutex);
+                for (int fd : worker.newConnections) {
+                    connections.push_back({fd, {}, {}, 0});
+                }
+                worker.newConnections.clear();
+            }
+
+            // Connections added above were not polled yet, so only the polled ones are checked
+            size_t polledConnections = polled.size() - 1;
+            for (size_t i = 0; i < polledConnections; i++) {
+                Connection& connection = connections[i];
+                bool open = true;
+                short revents = polled[i + 1].revents;
+                if (revents & POLLIN) {
+                    open = readRequests(connection, buffer, sizeof(buffer), seeds);
+                }
+                else if (revents & (POLLHUP | POLLERR)) {
+                    open = (polled[i + 1].events & POLLIN) && readRequests(connection, buffer, sizeof(buffer), seeds);
+                }
+                if (open) {
+                    open = flush(connection, seeds);
+                }
+                if (!open) {
+                    close(connection.fd);
+                    connection.fd = -1;
+                }
+            }
+            connections.erase(remove_if(connections.begin(), connections.end(),
+                                        [](const Connection& connection) { return connection.fd < 0; }),
+                              connections.end());
+        }
+
+        for (const Connection& connection : connections) {
+            close(connection.fd);
+        }
+    }
+
+    // Reads what the connection sent and answers every complete request. Returns false once it closed.
+    bool readRequests(Connection& connection, uint8_t* buffer, size_t size, Rng& seeds) {
+        ssize_t received = read(connection.fd, buffer, size);
+        if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            return false;
+        }
+        if (received < 0) {
+            return true;
+        }
+        connection.input.insert(connection.input.end(), buffer, buffer + received);
+        return answerRequests(connection, seeds);
+    }
+
+    // Answers the complete requests read so far, stopping while too many responses are unsent.
+    // Returns false if a request is malformed.
+    bool answerRequests(Connection& connection, Rng& seeds) {
+        size_t offset = 0;
+        while (connection.input.size() - offset >= 4 && connection.pendingOutput() < SERVER_MAX_PENDING_OUTPUT) {
+            uint32_t length = getU32(connection.input.data() + offset);
+            if (length > SERVER_MAX_REQUEST || length < 9) {
+                return false;
+            }
+            if (connection.input.size() - offset - 4 < length) {
+                break;
+            }
+            handle(connection.input.data() + offset + 4, length, connection.output, seeds);
+            offset += 4 + length;
+        }
+        connection.input.erase(connection.input.begin(), connection.input.begin() + (ptrdiff_t)offset);
+        return true;
+    }
+
+    // Sends what it can of the responses, answering requests left over from when reading paused as the
+    // client catches up. Returns false once the connection closed.
+    bool flush(Connection& connection, Rng& seeds) {
+        while (connection.pendingOutput() > 0) {
+            if (!writeOutput(connection)) {
+                return false;
+            }
+            size_t unanswered = connection.input.size();
+            if (unanswered == 0 || connection.pendingOutput() >= SERVER_MAX_PENDING_OUTPUT) {
+                return true;
+            }
+            if (!answerRequests(connection, seeds)) {
+                return false;
+            }
+            if (connection.input.size() == unanswered) {
+                return true;
+            }
+        }
+        return true;
+    }
+
+    // Writes pending output until the socket would block. Returns false if the write failed.
+    bool writeOutput(Connection& connection) {
+        while (connection.outputSent < connection.output.size()) {
+            ssize_t sent = write(connection.fd, connection.output.data() + connection.outputSent,
+                                 connection.output.size() - connection.outputSent);
+            if (sent < 0) {
+                // Drop what was sent once it is most of the buffer, so a client that reads but never lets the
+                // buffer drain completely does not keep growing it
+                if (connection.outputSent > connection.output.size() / 2) {
+                    connection.output.erase(connection.output.begin(),
+                                            connection.output.begin() + (ptrdiff_t)connection.outputSent);
+                    connection.outputSent = 0;
+                }
+                return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+            }
+            connection.outputSent += (size_t)sent;
+        }
+        connection.output.clear();
+        connection.outputSent = 0;
+        return true;
+    }
+
+    Shard& shardOf(uint64_t sessionId) {
+        return shards[sessionId % SHARDS];
+    }
+
+    // Answers one request, appending the response to out
+    void handle(const uint8_t* request, uint32_t length, vector<uint8_t>& out, Rng& seeds) {
+        TraceScope scope("server_request");
+        requestCount.fetch_add(1, memory_order_relaxed);
+        uint8_t type = request[0];
+        uint64_t sessionId = getU64(request + 1);
+        const uint8_t* arguments = request + 9;
+        size_t start = beginMessage(out);
+
+        if (type == SERVER_NEW_GAME) {
+            if (length < 9 + 20) {
+                status(out, SERVER_BAD_REQUEST, type);
+            }
+            else {
+                newGame(sessionId, (int)getU32(arguments), (int)getU32(arguments + 4), (int)getU32(arguments + 8),
+                        getU64(arguments + 12), out, seeds);
+            }
+        }
+        else if (type == SERVER_CLOSE) {
+            Shard& shard = shardOf(sessionId);
+            lock_guard<mutex> lock(shard.lock);
+            if (shard.sessions.erase(sessionId) == 0) {
+                status(out, SERVER_UNKNOWN_SESSION, type);
+            }
+            else {
+                sessionCount--;
+                status(out, SERVER_OK, type);
+            }
+        }
+        else if (type >= SERVER_REVEAL && type <= SERVER_DIFF) {
+            Shard& shard = shardOf(sessionId);
+            lock_guard<mutex> lock(shard.lock);
+            auto found = shard.sessions.find(sessionId);
+            if (found == shard.sessions.end()) {
+                status(out, SERVER_UNKNOWN_SESSION, type);
+            }
+            else if (type != SERVER_DIFF && length < 9 + 8) {
+                status(out, SERVER_BAD_REQUEST, type);
+            }
+            else {
+                Session& session = *found->second;
+                session.lastUsed = chrono::steady_clock::now();
+                if (type == SERVER_DIFF) {
+                    diff(session.game, out);
+                }
+                else {
+                    play(session.game, type, (int)getU32(arguments), (int)getU32(arguments + 4), out);
+                }
+            }
+        }
+        else {
+            status(out, SERVER_BAD_REQUEST, type);
+        }
+        endMessage(out, start);
+    }
+
+    void status(vector<uint8_t>& out, ServerStatus code, uint8_t type) {
+        putU8(out, (uint8_t)code);
+        putU8(out, type);
+    }
+
+    void newGame(uint64_t sessionId, int rows, int cols, int mines, uint64_t seed, vector<uint8_t>& out, Rng& seeds) {
+        if (rows < 1 || cols < 1 || mines < 0 || (long long)rows * cols > SERVER_MAX_TILES) {
+            status(out, SERVER_BAD_REQUEST, SERVER_NEW_GAME);
+            return;
+        }
+        if (seed == 0) {
+            seed = seeds.next();
+        }
+
+        Session* session = nullptr;
+        if (sessionId == 0) {
+            if (sessionCount.fetch_add(1) >= maxSessions) {
+                sessionCount--;
+                status(out, SERVER_TOO_MANY_SESSIONS, SERVER_NEW_GAME);
+                return;
+            }
+            // Built outside the shard lock, since large boards take a while
+            auto created = make_unique<Session>(rows, cols, min(mines, rows * cols), seed);
+            sessionId = nextSessionId.fetch_add(1);
+            Shard& shard = shardOf(sessionId);
+            lock_guard<mutex> lock(shard.lock);
+            session = created.get();
+            session->lastUsed = chrono::steady_clock::now();
+            shard.sessions[sessionId] = move(created);
+            newGameResponse(sessionId, *session, out);
+            return;
+        }
+
+        Shard& shard = shardOf(sessionId);
+        lock_guard<mutex> lock(shard.lock);
+        auto found = shard.sessions.find(sessionId);
+        if (found == shard.sessions.end()) {
+            status(out, SERVER_UNKNOWN_SESSION, SERVER_NEW_GAME);
+            return;
+        }
+        session = found->second.get();
+        // The same size starts over in place, which does not allocate. Another size needs a new game.
+        if (rows == session->game.rows() && cols == session->game.cols()) {
+            session->game.board._mines = session->game.board.playableMines(mines);
+            session->game.reset(seed);
+        }
+        else {
+            session->game = Game(rows, cols, min(mines, rows * cols), seed);
+        }
+        session->lastUsed = chrono::steady_clock::now();
+        newGameResponse(sessionId, *session, out);
+    }
+
+    void newGameResponse(uint64_t sessionId, const Session& session, vector<uint8_t>& out) {
+        status(out, SERVER_OK, SERVER_NEW_GAME);
+        putU64(out, sessionId);
+        putU32(out, (uint32_t)session.game.rows());
+        putU32(out, (uint32_t)session.game.cols());
+        putU32(out, (uint32_t)session.game.mines());
+    }
+
+    static uint8_t outcome(const Game& game) {
+        return game.gameWon ? 1 : game.gameLost ? 2 : 0;
+    }
+
+    // What a player may see of a tile
+    static uint8_t look(const Game& game, int index) {
+        const Tile& tile = game.board.tiles[index];
+        if (tile.isFlagged()) {
+            return SERVER_FLAGGED;
+        }
+        if (tile.isMined() && (tile.isRevealed() || game.gameLost)) {
+            return SERVER_MINE;
+        }
+        if (tile.isRevealed()) {
+            return (uint8_t)tile.adjacentMineCount();
+        }
+        return SERVER_HIDDEN;
+    }
+
+    void play(Game& game, uint8_t type, int row, int col, vector<uint8_t>& out) {
+        uint32_t changed = 0;
+        if (type == SERVER_REVEAL) {
+            changed = (uint32_t)game.reveal(row, col).size();
+        }
+        else if (type == SERVER_CHORD) {
+            changed = (uint32_t)game.chord(row, col).size();
+        }
+        else {
+            changed = game.toggleFlag(row, col) ? 1 : 0;
+        }
+        // A client that never asks for diffs would let the change list grow with every flag
+        if (game.changedTiles.size() > (size_t)game.rows() * game.cols()) {
+            game.changedTiles.clear();
+            game.boardChanged = true;
+        }
+        status(out, SERVER_OK, type);
+        putU8(out, outcome(game));
+        putU32(out, changed);
+    }
+
+    void diff(Game& game, vector<uint8_t>& out) {
+        status(out, SERVER_OK, SERVER_DIFF);
+        putU8(out, outcome(game));
+        putU32(out, (uint32_t)game.flagCounter);
+        int cols = game.cols();
+        if (game.boardChanged) {
+            putU32(out, (uint32_t)(game.rows() * cols));
+            for (int row = 0; row < game.rows(); row++) {
+                for (int col = 0; col < cols; col++) {
+                    putU32(out, (uint32_t)(row * cols + col));
+                    putU8(out, look(game, game.board.index(row, col)));
+                }
+            }
+        }
+        else {
+            putU32(out, (uint32_t)game.changedTiles.size());
+            for (int index : game.changedTiles) {
+                putU32(out, (uint32_t)(game.board.rowOf(index) * cols + game.board.colOf(index)));
+                putU8(out, look(game, index));
+            }
+        }
+        game.clearChanges();
+    }
+
+    void closeIdleSessions() {
+        auto oldest = chrono::steady_clock::now() - chrono::minutes(IDLE_MINUTES);
+        for (Shard& shard : shards) {
+            lock_guard<mutex> lock(shard.lock);
+            for (auto it = shard.sessions.begin(); it != shard.sessions.end();) {
+                if (it->second->lastUsed < oldest) {
+                    it = shard.sessions.erase(it);
+                    sessionCount--;
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,241 @@
+#pragma once
+#include "game.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+// Snapshots of a Game that share the parts of the board they have in common, for undo and for trying
+// hypothetical moves. The tiles are kept in a tree of immutable nodes: leaves hold LEAF_TILES consecutive
+// tiles of the padded board, and inner nodes hold up to FANOUT children. Taking a snapshot copies only the
+// leaves holding tiles that changed since the previous one, and the inner nodes on their paths, and shares
+// every other node with the previous snapshot. A snapshot with no changes costs a few counters, and one
+// after a move costs about LEAF_TILES bytes plus a path of pointers per changed leaf.
+// Restoring walks the current tree and the snapshot's together, skipping every shared node, so it also
+// touches only the leaves that differ.
+
+// Tiles of one leaf, or the children of an inner node
+struct SnapshotNode {
+    vector<shared_ptr<const SnapshotNode>> children;
+    vector<Tile> tiles;
+};
+
+// The mines only change when they are placed or a new game starts, so snapshots share them
+struct MineLayout {
+    vector<int> mineIndices;
+    vector<uint64_t> mineRows;
+    int mines = 0;
+};
+
+// The state of a game at one moment
+struct GameSnapshot {
+    shared_ptr<const SnapshotNode> tiles;
+    shared_ptr<const MineLayout> mines;
+    size_t tileCount = 0;           // Size of the padded board the snapshot was taken from
+    uint64_t seed = 0;
+    bool minesPlaced = false;
+    int nonMinesRevealed = 0;
+    int minesFlagged = 0;
+    int flagCounter = 0;
+    int lostIndex = -1;
+    bool gameLost = false;
+    bool gameWon = false;
+    uint64_t playMilliseconds = 0;  // Time on the timer, which the game itself does not keep
+    size_t bytesAdded = 0;          // Memory this snapshot added to what the previous one already shared
+};
+
+// Takes and restores snapshots of one game. The game journals its changed tiles while this exists.
+class GameSnapshots {
+public:
+    static const int LEAF_TILES = 128;
+    static const int FANOUT = 8;
+
+    Game& game;
+    shared_ptr<const SnapshotNode> root;    // The tiles as of the last snapshot or restore
+    shared_ptr<const MineLayout> mines;
+    int height = 0;                         // Levels of inner nodes above the leaves
+    size_t leafCount = 0;
+
+    explicit GameSnapshots(Game& snapshotGame) : game(snapshotGame) {
+        leafCount = (game.board.tiles.size() + LEAF_TILES - 1) / LEAF_TILES;
+        for (size_t span = 1; span < leafCount; span *= FANOUT) {
+            height++;
+        }
+        game.keepJournal = true;
+        game.journal.clear();
+        game.journalAll = true;
+    }
+
+    ~GameSnapshots() {
+        game.keepJournal = false;
+        game.journal.clear();
+    }
+
+    GameSnapshots(const GameSnapshots&) = delete;
+    GameSnapshots& operator=(const GameSnapshots&) = delete;
+
+    GameSnapshot take(uint64_t playMilliseconds = 0) {
+        GameSnapshot snapshot;
+        snapshot.bytesAdded = sync();
+        snapshot.tiles = root;
+        snapshot.mines = mines;
+        snapshot.tileCount = game.board.tiles.size();
+        snapshot.seed = game.seed;
+        snapshot.minesPlaced = game.board.minesPlaced;
+        snapshot.nonMinesRevealed = game.board.nonMinesRevealed;
+        snapshot.minesFlagged = game.board.minesFlagged;
+        snapshot.flagCounter = game.flagCounter;
+        snapshot.lostIndex = game.lostIndex;
+        snapshot.gameLost = game.gameLost;
+        snapshot.gameWon = game.gameWon;
+        snapshot.playMilliseconds = playMilliseconds;
+        return snapshot;
+    }
+
+    // Puts the game back in the state of a snapshot of it. The tiles that differ are added to the game's
+    // changed tiles for its view. Returns false if the snapshot is of a board of another size.
+    bool restore(const GameSnapshot& snapshot) {
+        if (snapshot.tileCount != game.board.tiles.size() || !snapshot.tiles) {
+            return false;
+        }
+        sync();
+
+        Board& board = game.board;
+        restoreNode(root.get(), snapshot.tiles.get(), height, 0);
+        root = snapshot.tiles;
+        if (snapshot.mines != mines) {
+            mines = snapshot.mines;
+            board.mineIndices = mines->mineIndices;
+            board.mineRows = mines->mineRows;
+            board._mines = mines->mines;
+            game.boardChanged = true;
+        }
+        board.seed = snapshot.seed;
+        board.minesPlaced = snapshot.minesPlaced;
+        board.nonMinesRevealed = snapshot.nonMinesRevealed;
+        board.minesFlagged = snapshot.minesFlagged;
+        game.seed = snapshot.seed;
+        game.flagCounter = snapshot.flagCounter;
+        game.lostIndex = snapshot.lostIndex;
+        game.gameLost = snapshot.gameLost;
+        game.gameWon = snapshot.gameWon;
+        game.floodFill.revealed.clear();
+        game.journal.clear();
+        game.journalAll = false;
+        return true;
+    }
+
+private:
+    vector<int> dirtyLeaves;        // Sorted leaves changed since the last sync, reused between syncs
+
+    // Brings the tree up to date with the board. Returns the bytes of the nodes it created.
+    size_t sync() {
+        size_t bytes = 0;
+        if (game.journalAll || !root) {
+            root = build(height, 0, bytes);
+            if (!mines || mines->mineIndices != game.board.mineIndices) {
+                auto layout = make_shared<MineLayout>();
+                layout->mineIndices = game.board.mineIndices;
+                layout->mineRows = game.board.mineRows;
+                layout->mines = game.board._mines;
+                bytes += sizeof(MineLayout) + layout->mineIndices.size() * sizeof(int)
+                         + layout->mineRows.size() * sizeof(uint64_t);
+                mines = layout;
+            }
+        }
+        else if (!game.journal.empty()) {
+            dirtyLeaves.clear();
+            for (int index : game.journal) {
+                dirtyLeaves.push_back(index / LEAF_TILES);
+            }
+            sort(dirtyLeaves.begin(), dirtyLeaves.end());
+            dirtyLeaves.erase(unique(dirtyLeaves.begin(), dirtyLeaves.end()), dirtyLeaves.end());
+            root = update(*root, height, 0, dirtyLeaves.data(), dirtyLeaves.data() + dirtyLeaves.size(), bytes);
+        }
+        game.journal.clear();
+        game.journalAll = false;
+        return bytes;
+    }
+
+    // Leaves under one node at a level
+    static size_t span(int level) {
+        size_t leaves = 1;
+        for (int i = 0; i < level; i++) {
+            leaves *= FANOUT;
+        }
+        return leaves;
+    }
+
+    shared_ptr<const SnapshotNode> makeLeaf(size_t leaf, size_t& bytes) const {
+        auto node = make_shared<SnapshotNode>();
+        const vector<Tile>& tiles = game.board.tiles;
+        size_t begin = leaf * LEAF_TILES;
+        size_t end = min(begin + LEAF_TILES, tiles.size());
+        node->tiles.assign(tiles.begin() + (ptrdiff_t)begin, tiles.begin() + (ptrdiff_t)end);
+        bytes += sizeof(SnapshotNode) + node->tiles.size() * sizeof(Tile);
+        return node;
+    }
+
+    shared_ptr<const SnapshotNode> build(int level, size_t firstLeaf, size_t& bytes) const {
+        if (level == 0) {
+            return makeLeaf(firstLeaf, bytes);
+        }
+        auto node = make_shared<SnapshotNode>();
+        size_t childSpan = span(level - 1);
+        for (size_t child = firstLeaf; child < leafCount && child < firstLeaf + childSpan * FANOUT; child += childSpan) {
+            node->children.push_back(build(level - 1, child, bytes));
+        }
+        bytes += sizeof(SnapshotNode) + node->children.size() * sizeof(node->children[0]);
+        return node;
+    }
+
+    // Copies the path to each dirty leaf in [dirty, dirtyEnd), which all lie under this node
+    shared_ptr<const SnapshotNode> update(const SnapshotNode& node, int level, size_t firstLeaf,
+                                          const int* dirty, const int* dirtyEnd, size_t& bytes) const {
+        if (level == 0) {
+            return makeLeaf(firstLeaf, bytes);
+        }
+        auto copy = make_shared<SnapshotNode>();
+        copy->children = node.children;
+        bytes += sizeof(SnapshotNode) + copy->children.size() * sizeof(copy->children[0]);
+        size_t childSpan = span(level - 1);
+        while (dirty < dirtyEnd) {
+            size_t child = ((size_t)*dirty - firstLeaf) / childSpan;
+            size_t childFirst = firstLeaf + child * childSpan;
+            const int* childEnd = dirty;
+            while (childEnd < dirtyEnd && (size_t)*childEnd < childFirst + childSpan) {
+                childEnd++;
+            }
+            copy->children[child] = update(*node.children[child], level - 1, childFirst, dirty, childEnd, bytes);
+            dirty = childEnd;
+        }
+        return copy;
+    }
+
+    // Writes the leaves of target that differ from current back to the board
+    void restoreNode(const SnapshotNode* current, const SnapshotNode* target, int level, size_t firstLeaf) {
+        if (current == target) {
+            return;
+        }
+        if (level == 0) {
+            size_t begin = firstLeaf * LEAF_TILES;
+            for (size_t i = 0; i < target->tiles.size(); i++) {
+                Tile& tile = game.board.tiles[begin + i];
+                if (tile.bits != target->tiles[i].bits) {
+                    tile = target->tiles[i];
+                    if (game.trackChanges) {
+                        game.changedTiles.push_back((int)(begin + i));
+                    }
+                }
+            }
+            return;
+        }
+        size_t childSpan = span(level - 1);
+        for (size_t child = 0; child < target->children.size(); child++) {
+            restoreNode(current->children[child].get(), target->children[child].get(), level - 1,
+                        firstLeaf + child * childSpan);
+        }
+    }
+};
@@ -0,0 +1,237 @@
+#pragma once
+#include "board.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Deduces safe tiles and certain mines from what the player can see: the counts of revealed tiles and the
+// flags (flags are trusted as mines). Revealed numbers whose surroundings changed are kept in a worklist, so
+// each new reveal only re-examines the numbers around it instead of rescanning the board.
+//
+// Two rules are applied to every number on the worklist:
+//   single tile: if the flags around a number match it, its other hidden neighbors are safe; if its hidden
+//                neighbors are exactly the mines it still needs, they are all mines.
+//   subset:      if the hidden neighbors of one number are a subset of another's, the difference holds the
+//                difference of their remaining mines, which may make all of it safe or all of it mines.
+class Solver {
+public:
+    // What the solver knows about a tile
+    enum Knowledge : uint8_t {UNKNOWN, SAFE, MINE};
+
+    const Board* board = nullptr;
+    vector<uint8_t> known;      // What the solver has deduced about each tile index
+    vector<int> worklist;       // Revealed numbers to examine
+    vector<uint8_t> queued;     // Whether a tile index is on the worklist
+    vector<int> safeTiles;      // Tiles deduced safe, in the order they were found
+    vector<int> mineTiles;      // Tiles deduced to be mines, in the order they were found
+    int pairOffsets[24];        // Offsets to every tile within two steps, the numbers that can share neighbors
+
+    // Starts solving a board from its current visible state. Keeps the buffers' capacity across games.
+    void reset(const Board& newBoard) {
+        board = &newBoard;
+        known.assign(board->tiles.size(), UNKNOWN);
+        queued.assign(board->tiles.size(), 0);
+        worklist.clear();
+        safeTiles.clear();
+        mineTiles.clear();
+        // A tile is on the worklist and deduced at most once, so after the first board of a size these never grow
+        worklist.reserve(board->tiles.size());
+        safeTiles.reserve(board->tiles.size());
+        mineTiles.reserve(board->tiles.size());
+
+        int pair = 0;
+        for (int dr = -2; dr <= 2; dr++) {
+            for (int dc = -2; dc <= 2; dc++) {
+                if (dr != 0 || dc != 0) {
+                    pairOffsets[pair++] = dr * board->_stride + dc;
+                }
+            }
+        }
+
+        for (int row = 0; row < board->_rows; row++) {
+            for (int col = 0; col < board->_cols; col++) {
+                enqueue(board->index(row, col));
+            }
+        }
+    }
+
+    // Queues the numbers affected by newly revealed tiles, such as the batch returned by Game::reveal.
+    void notifyRevealed(const vector<int>& revealed) {
+        for (int index : revealed) {
+            enqueue(index);
+            enqueueNeighbors(index);
+        }
+    }
+
+    // Queues the numbers around a tile whose flag was placed or removed.
+    void notifyFlagChanged(int index) {
+        enqueueNeighbors(index);
+    }
+
+    // Queues the numbers around a tile whose mine was added or removed, changing their counts. Whatever was
+    // deduced stays known, so only undecided tiles may be changed this way (noguess.h does).
+    void notifyMineMoved(int index) {
+        enqueueNeighbors(index);
+    }
+
+    // Applies the rules until the worklist is empty. New deductions are appended to safeTiles and mineTiles.
+    void solve() {
+        while (!worklist.empty()) {
+            int index = worklist.back();
+            worklist.pop_back();
+            queued[index] = 0;
+
+            Constraint constraint = constraintOf(index);
+            if (constraint.hidden == 0) {
+                continue;
+            }
+            if (constraint.mines == 0) {
+                markAll(index, constraint.hidden, SAFE);
+                continue;
+            }
+            if (constraint.mines == popcount8(constraint.hidden)) {
+                markAll(index, constraint.hidden, MINE);
+                continue;
+            }
+            applySubsetRule(index, constraint);
+        }
+    }
+
+    // Whether the tile is deduced safe and not revealed yet
+    bool isSafeToReveal(int index) const {
+        return known[index] == SAFE && !board->tiles[index].isRevealed();
+    }
+
+private:
+    // The hidden, undecided neighbors of a number as a mask over the eight neighbor offsets,
+    // and how many mines are still missing among them
+    struct Constraint {
+        int hidden = 0;
+        int mines = 0;
+    };
+
+    static int popcount8(int mask) {
+        int count = 0;
+        for (; mask; mask &= mask - 1) {
+            count++;
+        }
+        return count;
+    }
+
+    bool isNumber(int index) const {
+        const Tile& tile = board->tiles[index];
+        return tile.isRevealed() && !tile.isBorder() && !tile.isMined() && tile.adjacentMineCount() > 0;
+    }
+
+    void enqueue(int index) {
+        if (!queued[index] && isNumber(index)) {
+            queued[index] = 1;
+            worklist.push_back(index);
+        }
+    }
+
+    void enqueueNeighbors(int index) {
+        for (int offset : board->neighborOffsets) {
+            enqueue(index + offset);
+        }
+    }
+
+    Constraint constraintOf(int index) const {
+        Constraint constraint;
+        constraint.mines = board->tiles[index].adjacentMineCount();
+        for (int k = 0; k < 8; k++) {
+            int neighbor = index + board->neighborOffsets[k];
+            const Tile& tile = board->tiles[neighbor];
+            if (tile.isFlagged() || known[neighbor] == MINE) {
+                constraint.mines--;
+            }
+            else if (!tile.isRevealed() && known[neighbor] == UNKNOWN) {
+                constraint.hidden |= 1 << k;
+            }
+        }
+        return constraint;
+    }
+
+    void mark(int tile, Knowledge value) {
+        if (known[tile] != UNKNOWN) {
+            return;
+        }
+        known[tile] = value;
+        (value == SAFE ? safeTiles : mineTiles).push_back(tile);
+        enqueueNeighbors(tile);     // Every number around it has one less undecided neighbor
+    }
+
+    void markAll(int index, int hidden, Knowledge value) {
+        for (int k = 0; k < 8; k++) {
+            if (hidden & (1 << k)) {
+                mark(index + board->neighborOffsets[k], value);
+            }
+        }
+    }
+
+    // Whether every tile in a's hidden set is also a neighbor of b
+    bool isSubset(int a, int aHidden, int b) const {
+        for (int k = 0; k < 8; k++) {
+            if ((aHidden & (1 << k)) && !isAround(a + board->neighborOffsets[k], b)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Compares the number with every number that can share hidden neighbors with it.
+    void applySubsetRule(int index, const Constraint& constraint) {
+        int hiddenCount = popcount8(constraint.hidden);
+        for (int offset : pairOffsets) {
+            int other = index + offset;
+            if (other < 0 || other >= (int)board->tiles.size() || !isNumber(other)) {
+                continue;
+            }
+            Constraint otherConstraint = constraintOf(other);
+            int otherCount = popcount8(otherConstraint.hidden);
+            if (otherConstraint.hidden == 0) {
+                continue;
+            }
+
+            // This number's hidden tiles inside the other's: the rest of the other's hold the difference
+            if (otherCount > hiddenCount && isSubset(index, constraint.hidden, other)) {
+                resolveDifference(other, otherConstraint, index, constraint, otherCount - hiddenCount);
+            }
+            // The other's hidden tiles inside this number's
+            else if (hiddenCount > otherCount && isSubset(other, otherConstraint.hidden, index)) {
+                resolveDifference(index, constraint, other, otherConstraint, hiddenCount - otherCount);
+            }
+
+            // A deduction changes this number's constraint; it is back on the worklist
+            if (queued[index]) {
+                return;
+            }
+        }
+    }
+
+    // The hidden tiles of outer that are not around inner hold outer's remaining mines minus inner's.
+    // Hidden tiles around inner are exactly inner's hidden set, so this is the set difference.
+    void resolveDifference(int outer, const Constraint& outerConstraint, int inner, const Constraint& innerConstraint, int differenceCount) {
+        int differenceMines = outerConstraint.mines - innerConstraint.mines;
+        if (differenceMines != 0 && differenceMines != differenceCount) {
+            return;
+        }
+        Knowledge value = differenceMines == 0 ? SAFE : MINE;
+        for (int k = 0; k < 8; k++) {
+            if (outerConstraint.hidden & (1 << k)) {
+                int tile = outer + board->neighborOffsets[k];
+                if (!isAround(tile, inner)) {
+                    mark(tile, value);
+                }
+            }
+        }
+    }
+
+    // Whether two tile indices are within one step of each other
+    bool isAround(int tile, int other) const {
+        int dr = tile / board->_stride - other / board->_stride;
+        int dc = tile % board->_stride - other % board->_stride;
+        return dr >= -1 && dr <= 1 && dc >= -1 && dc <= 1;
+    }
+};
@@ -1,26 +1,238 @@
 #pragma once
+#include "threadpool.h"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(MINESWEEPER_EMBEDDED_ASSETS)
+#include "assetbundle.h"        // Generated by tools/bundle.cpp
+#endif
 
+using namespace std;
+
+// Handles of the images in the texture atlas, in the order of Textures::textureNames.
+// TEXTURE_EMPTY is a transparent tile-sized cell that has no image file.
+enum TextureId {
+    TEXTURE_DEBUG, TEXTURE_DIGITS, TEXTURE_FACE_HAPPY, TEXTURE_FACE_LOSE, TEXTURE_FACE_WIN, TEXTURE_FLAG,
+    TEXTURE_LEADERBOARD, TEXTURE_MINE, TEXTURE_NUMBER_1, TEXTURE_NUMBER_2, TEXTURE_NUMBER_3, TEXTURE_NUMBER_4,
+    TEXTURE_NUMBER_5, TEXTURE_NUMBER_6, TEXTURE_NUMBER_7, TEXTURE_NUMBER_8, TEXTURE_PAUSE, TEXTURE_PLAY,
+    TEXTURE_TILE_HIDDEN, TEXTURE_TILE_REVEALED, TEXTURE_EMPTY, TEXTURE_COUNT
+};
+
+// Loads every image once and packs them into a single texture, shared by reference with the screens
+// and the board renderer. Sprites select an image by setting the atlas and the image's rect.
+// The font is loaded here too, so every screen shares one.
+//
+// The assets come from the first of these that loads:
+//   1. The bundle compiled into the program, when built with MINESWEEPER_EMBEDDED_ASSETS.
+//   2. The bundle file files/assets.bundle.
+//   3. The image files, decoded on every core and packed, and the font file.
+// A bundle is written by tools/bundle.cpp. It holds the atlas already packed as raw RGBA, so loading it is
+// one upload with no PNG decoding. Layout (little-endian): char[4] "MSAB", uint32 version, uint32 atlas
+// width and height, uint32 image count, int32 left, top, width and height of each image, uint32 font size,
+// the font file, then the atlas pixels.
 class Textures {
 public:
-    // Store all textures
-    map<string, sf::Texture> textures;
-    vector<string> textureNames = {"debug", "digits", "face_happy", "face_lose", "face_win", "flag", "leaderboard",
-                                   "mine", "number_1", "number_2", "number_3", "number_4", "number_5", "number_6",
-                                   "number_7", "number_8", "pause", "play", "tile_hidden", "tile_revealed"};
+    static const int ATLAS_WIDTH = 512;     // Images are packed in rows up to this wide
+    static const int DIGIT_WIDTH = 21;      // The digits image is a strip of 0-9 and a minus sign
+    static const int DIGIT_HEIGHT = 32;
+    static const int EMPTY_SIZE = 32;
+    static const uint32_t BUNDLE_VERSION = 1;
+
+    sf::Texture atlas;
+    sf::IntRect rects[TEXTURE_COUNT];
+    sf::Font font;
+    bool loaded = true;         // False if any asset was missing or broken
+    const char* textureNames[TEXTURE_EMPTY] = {"debug", "digits", "face_happy", "face_lose", "face_win", "flag",
+                                               "leaderboard", "mine", "number_1", "number_2", "number_3", "number_4",
+                                               "number_5", "number_6", "number_7", "number_8", "pause", "play",
+                                               "tile_hidden", "tile_revealed"};
     string path = "files/images/";
     string type = ".png";
+    string fontPath = "files/font.ttf";
+    string bundlePath = "files/assets.bundle";
 
-    Textures() {
-        for (const auto& textureName : textureNames) {
-            sf::Texture texture;
-            if (!texture.loadFromFile(path + textureName + type)) {
-                cout << "Error loading texture: " << textureName << endl;
-            }
-            textures[textureName] = texture;
+    // A bundle is skipped if useBundle is false, which tools/bundle.cpp uses to build a new one.
+    explicit Textures(bool useBundle = true) {
+#if defined(MINESWEEPER_EMBEDDED_ASSETS)
+        if (useBundle && loadBundle(ASSET_BUNDLE, sizeof(ASSET_BUNDLE))) {
+            return;
+        }
+#endif
+        if (useBundle && readFile(bundlePath, fileData) && loadBundle(fileData.data(), fileData.size())) {
+            return;
+        }
+        loadFiles();
+    }
+
+    Textures(const Textures&) = delete;
+    Textures& operator=(const Textures&) = delete;
+
+    const sf::IntRect& rect(TextureId id) const {
+        return rects[id];
+    }
+
+    // The cell of one digit in the digits strip. Digit 10 is the minus sign.
+    sf::IntRect digitRect(int digit) const {
+        const sf::IntRect& digits = rects[TEXTURE_DIGITS];
+        return sf::IntRect(digits.left + digit * DIGIT_WIDTH, digits.top, DIGIT_WIDTH, DIGIT_HEIGHT);
+    }
+
+    void apply(sf::Sprite& sprite, TextureId id) const {
+        sprite.setTexture(atlas);
+        sprite.setTextureRect(rects[id]);
+    }
+
+    void applyDigit(sf::Sprite& sprite, int digit) const {
+        sprite.setTexture(atlas);
+        sprite.setTextureRect(digitRect(digit));
+    }
+
+    // Writes the loaded assets as a bundle. Only possible after every image and the font loaded from their
+    // files: after a bundle, fileData holds the bundle and not the font.
+    bool writeBundle(const string& bundleFile) const {
+        if (!loadedFromFiles) {
+            return false;
+        }
+        sf::Image atlasImage = atlas.copyToImage();
+        sf::Vector2u size = atlasImage.getSize();
+        if (fileData.empty() || size.x == 0 || atlasImage.getPixelsPtr() == nullptr) {
+            return false;
+        }
+
+        vector<uint8_t> bundle = {'M', 'S', 'A', 'B'};
+        putU32(bundle, BUNDLE_VERSION);
+        putU32(bundle, size.x);
+        putU32(bundle, size.y);
+        putU32(bundle, TEXTURE_COUNT);
+        for (const sf::IntRect& rect : rects) {
+            putU32(bundle, (uint32_t)rect.left);
+            putU32(bundle, (uint32_t)rect.top);
+            putU32(bundle, (uint32_t)rect.width);
+            putU32(bundle, (uint32_t)rect.height);
+        }
+        putU32(bundle, (uint32_t)fileData.size());
+        bundle.insert(bundle.end(), fileData.begin(), fileData.end());
+        const uint8_t* pixels = atlasImage.getPixelsPtr();
+        bundle.insert(bundle.end(), pixels, pixels + (size_t)size.x * size.y * 4);
+
+        ofstream outfile(bundleFile, ios::binary);
+        outfile.write((const char*)bundle.data(), (streamsize)bundle.size());
+        return (bool)outfile;
+    }
+
+private:
+    // The bundle file or the font file. The font reads from it for as long as it is used.
+    vector<uint8_t> fileData;
+    bool loadedFromFiles = false;   // Every asset came from the image and font files, none from a bundle
+
+    static bool readFile(const string& file, vector<uint8_t>& data) {
+        ifstream infile(file, ios::binary);
+        if (!infile) {
+            return false;
+        }
+        data.assign(istreambuf_iterator<char>(infile), istreambuf_iterator<char>());
+        return true;
+    }
+
+    static void putU32(vector<uint8_t>& out, uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            out.push_back((uint8_t)(value >> (8 * i)));
+        }
+    }
+
+    static uint32_t getU32(const uint8_t* in) {
+        return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+    }
+
+    // Loads the atlas and the font from a bundle in memory, which must outlive this object.
+    // Returns false, loading nothing, if it is not a bundle of this version with these images.
+    bool loadBundle(const uint8_t* data, size_t size) {
+        size_t headerSize = 20 + TEXTURE_COUNT * 16 + 4;
+        if (size < headerSize || memcmp(data, "MSAB", 4) != 0 || getU32(data + 4) != BUNDLE_VERSION
+            || getU32(data + 16) != TEXTURE_COUNT) {
+            return false;
+        }
+        uint32_t width = getU32(data + 8);
+        uint32_t height = getU32(data + 12);
+        size_t fontSize = getU32(data + headerSize - 4);
+        size_t pixelBytes = (size_t)width * height * 4;
+        if (width == 0 || height == 0 || size - headerSize < fontSize || size - headerSize - fontSize != pixelBytes) {
+            return false;
+        }
+
+        const uint8_t* rectData = data + 20;
+        for (int id = 0; id < TEXTURE_COUNT; id++) {
+            const uint8_t* entry = rectData + id * 16;
+            rects[id] = sf::IntRect((int)getU32(entry), (int)getU32(entry + 4), (int)getU32(entry + 8), (int)getU32(entry + 12));
         }
+        const uint8_t* fontData = data + headerSize;
+        if (!atlas.create(width, height) || !font.loadFromMemory(fontData, fontSize)) {
+            return false;
+        }
+        atlas.update(fontData + fontSize);
+        return true;
     }
 
-    sf::Texture& getTexture(const string& textureName) {
-        return textures[textureName];
+    // Decodes the image files on every core while the font file is read, then packs the images.
+    void loadFiles() {
+        sf::Image images[TEXTURE_COUNT];
+        bool decoded[TEXTURE_EMPTY] = {};
+        {
+            ThreadPool pool(min((int)thread::hardware_concurrency(), (int)TEXTURE_EMPTY));
+            for (int id = 0; id < TEXTURE_EMPTY; id++) {
+                pool.submit([this, &images, &decoded, id]() {
+                    decoded[id] = images[id].loadFromFile(path + textureNames[id] + type);
+                });
+            }
+            if (!readFile(fontPath, fileData) || !font.loadFromMemory(fileData.data(), fileData.size())) {
+                cout << "Font file failed to load." << endl;
+                fileData.clear();
+                loaded = false;
+            }
+            pool.wait();
+        }
+        for (int id = 0; id < TEXTURE_EMPTY; id++) {
+            if (!decoded[id]) {
+                cout << "Error loading texture: " << textureNames[id] << endl;
+                loaded = false;
+            }
+        }
+        images[TEXTURE_EMPTY].create(EMPTY_SIZE, EMPTY_SIZE, sf::Color::Transparent);
+
+        // Place the images left to right, starting a new row when one would run past the atlas width
+        int x = 0;
+        int y = 0;
+        int rowHeight = 0;
+        int width = 0;
+        for (int id = 0; id < TEXTURE_COUNT; id++) {
+            sf::Vector2u size = images[id].getSize();
+            if (x > 0 && x + (int)size.x > ATLAS_WIDTH) {
+                x = 0;
+                y += rowHeight;
+                rowHeight = 0;
+            }
+            rects[id] = sf::IntRect(x, y, (int)size.x, (int)size.y);
+            x += (int)size.x;
+            rowHeight = max(rowHeight, (int)size.y);
+            width = max(width, x);
+        }
+
+        sf::Image atlasImage;
+        atlasImage.create((unsigned)max(width, 1), (unsigned)max(y + rowHeight, 1), sf::Color::Transparent);
+        for (int id = 0; id < TEXTURE_COUNT; id++) {
+            atlasImage.copy(images[id], (unsigned)rects[id].left, (unsigned)rects[id].top);
+        }
+        if (!atlas.loadFromImage(atlasImage)) {
+            cout << "Error creating the texture atlas." << endl;
+            loaded = false;
+        }
+        loadedFromFiles = loaded;
     }
-};
\ No newline at end of file
+};
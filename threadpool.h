@@ -0,0 +1,86 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// A fixed set of worker threads taking tasks from one queue. Created once and reused, so running a
+// batch of tasks does not pay for starting threads.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads = (int)thread::hardware_concurrency()) {
+        threads = max(threads, 1);
+        for (int i = 0; i < threads; i++) {
+            workers.emplace_back([this]() { work(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            stopping = true;
+        }
+        taskReady.notify_all();
+        for (thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const {
+        return (int)workers.size();
+    }
+
+    void submit(function<void()> task) {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            tasks.push(move(task));
+            pending++;
+        }
+        taskReady.notify_one();
+    }
+
+    // Blocks until every submitted task has finished
+    void wait() {
+        unique_lock<mutex> lock(queueMutex);
+        allDone.wait(lock, [this]() { return pending == 0; });
+    }
+
+private:
+    vector<thread> workers;
+    queue<function<void()>> tasks;
+    mutex queueMutex;
+    condition_variable taskReady;
+    condition_variable allDone;
+    int pending = 0;        // Tasks submitted and not finished
+    bool stopping = false;
+
+    void work() {
+        while (true) {
+            function<void()> task;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                taskReady.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                if (tasks.empty()) {
+                    return;
+                }
+                task = move(tasks.front());
+                tasks.pop();
+            }
+
+            task();
+
+            lock_guard<mutex> lock(queueMutex);
+            if (--pending == 0) {
+                allDone.notify_all();
+            }
+        }
+    }
+};
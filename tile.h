@@ -1,39 +1,65 @@
 #pragma once
-#include <vector>
+#include <cstdint>
 
 using namespace std;
 
+// A single cell of the board, packed into one byte so the board can be stored contiguously.
+// The low four bits hold the adjacent mine count and the upper four bits hold the state flags.
 class Tile {
 public:
-    bool revealed;  // The tile has been revealed or not.
-    bool flagged;   // The tile has a flag or not. If flagged, cannot left-click. Right-click removes the flag.
-    bool mined;     // The tile has a mine or not
-    int adjacentMineCount;  // The number of mines that are adjacent to this tile.
-
-    vector<Tile*> adjacentTiles;    // 2D vector of adjacent tiles
-
-    Tile() {
-        revealed = false;
-        flagged = false;
-        mined = false;
-        adjacentMineCount = 0;
-
-        // Initialize the neighbors to nullptr (adjusted later when constructing the board).
-        for (int i = 0; i < 8; i++) {
-            Tile* tile = nullptr;
-            adjacentTiles.push_back(tile);
-        }
+    static const uint8_t COUNT_MASK = 0x0F;    // The number of mines that are adjacent to this tile.
+    static const uint8_t MINED = 0x10;         // The tile has a mine or not
+    static const uint8_t REVEALED = 0x20;      // The tile has been revealed or not.
+    static const uint8_t FLAGGED = 0x40;       // The tile has a flag or not. If flagged, cannot left-click.
+    static const uint8_t BORDER = 0x80;        // Padding tile around the edge of the board, never playable.
+
+    uint8_t bits = 0;
 
+    bool isMined() const {
+        return (bits & MINED) != 0;
     }
 
-    // Determines the number of adjacent mines to this tile.
-    int countAdjacentMines() {
-        for (auto tile : adjacentTiles) {
-            if (tile != nullptr && tile->mined) {
-                adjacentMineCount++;
-            }
-        }
+    bool isRevealed() const {
+        return (bits & REVEALED) != 0;
+    }
+
+    bool isFlagged() const {
+        return (bits & FLAGGED) != 0;
+    }
 
-        return adjacentMineCount;
+    bool isBorder() const {
+        return (bits & BORDER) != 0;
     }
-};
\ No newline at end of file
+
+    int adjacentMineCount() const {
+        return bits & COUNT_MASK;
+    }
+
+    void setMined(bool mined) {
+        setBit(MINED, mined);
+    }
+
+    void setRevealed(bool revealed) {
+        setBit(REVEALED, revealed);
+    }
+
+    void setFlagged(bool flagged) {
+        setBit(FLAGGED, flagged);
+    }
+
+    void setAdjacentMineCount(int count) {
+        bits = (uint8_t)((bits & ~COUNT_MASK) | (count & COUNT_MASK));
+    }
+
+private:
+    void setBit(uint8_t bit, bool value) {
+        if (value) {
+            bits |= bit;
+        }
+        else {
+            bits &= (uint8_t)~bit;
+        }
+    }
+};
+
+static_assert(sizeof(Tile) == 1, "Tile must stay packed into a single byte");
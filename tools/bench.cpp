@@ -0,0 +1,246 @@
+// Benchmark suite for the board and screen hot paths, at the beginner, intermediate, expert and 1000x1000
+// board sizes. Prints one JSON document with the time and heap allocations per operation of each
+// benchmark, so results can be compared between releases.
+//
+// Benchmarks, and the old code paths they cover:
+//   board_construction    Board construction and mine placement (the neighbor lists of findNeighbors are now
+//                         the fixed neighborOffsets, set up by the constructor)
+//   count_adjacent_mines  The adjacent mine counts that setNumberSprites used to compute
+//   renderer_rebuild      Rebuilding every tile quad, what setNumberSprites did to the sprites
+//   flood_fill_reveal     The first reveal of a game, which floods the opening (floodFillReveal)
+//   game_reset            Game::reset and the first reveal of the next game, on the reused board
+//   screen_reset          GameScreen::reset, which used to build a new board and leak the old tiles
+//   store_result          GameScreen::storeResult
+//   update_timer          GameScreen::updateTimer
+//   frame                 A full GameScreen::drawToScreen frame, rendered offscreen into a window of at most
+//                         1280x900, as the game sizes it on a large screen, so larger boards are scrolled. Its time
+//                         should depend on the window size and not on the board size.
+// Allocations are counted on the benchmark's thread only, so the score store's writer thread is not included.
+// The reset benchmarks run once before they are measured. They and the timer update must not allocate, or the bench
+// exits with 1.
+//
+// Build from the repository root and run it there, since it loads the textures from files/:
+//   g++ -std=c++17 -O2 -I. tools/bench.cpp -o bench -lsfml-graphics -lsfml-window -lsfml-system -pthread
+// Usage: bench [output file]
+#include <SFML/Graphics.hpp>
+#include "screens.h"
+#include "textures.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Heap allocations made by the current thread
+thread_local long long threadAllocations = 0;
+
+void* operator new(size_t size) {
+    threadAllocations++;
+    void* memory = malloc(size ? size : 1);
+    if (!memory) {
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+// Each benchmark runs until it has been measured for this long, and at least MIN_ITERATIONS times.
+// It also stops after MAX_WALL_SECONDS including its setup, which can be much slower than the operation.
+const double MIN_SECONDS = 0.25;
+const double MAX_WALL_SECONDS = 2.0;
+const long long MIN_ITERATIONS = 3;
+const long long MAX_ITERATIONS = 1000000;
+
+struct BoardSize {
+    string name;
+    int rows;
+    int cols;
+    int mines;
+};
+
+struct Result {
+    string name;
+    BoardSize size;
+    long long iterations;
+    double nanoseconds;     // Per operation
+    double allocations;     // Per operation
+};
+
+// Runs setup (not measured) then operation until enough time has been measured.
+template <typename Setup, typename Operation>
+Result measure(const string& name, const BoardSize& size, Setup setup, Operation operation) {
+    Result result = {name, size, 0, 0, 0};
+    double seconds = 0;
+    long long allocations = 0;
+    auto wallStart = chrono::steady_clock::now();
+    auto wallSeconds = [&]() { return chrono::duration<double>(chrono::steady_clock::now() - wallStart).count(); };
+    while (result.iterations < MIN_ITERATIONS
+           || (seconds < MIN_SECONDS && result.iterations < MAX_ITERATIONS && wallSeconds() < MAX_WALL_SECONDS)) {
+        setup();
+        long long allocationsBefore = threadAllocations;
+        auto start = chrono::steady_clock::now();
+        operation();
+        seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        allocations += threadAllocations - allocationsBefore;
+        result.iterations++;
+    }
+    result.nanoseconds = seconds * 1e9 / result.iterations;
+    result.allocations = (double)allocations / result.iterations;
+    cerr << "  " << name << ": " << result.nanoseconds << " ns/op, " << result.allocations << " allocations/op" << endl;
+    return result;
+}
+
+template <typename Operation>
+Result measure(const string& name, const BoardSize& size, Operation operation) {
+    return measure(name, size, []() {}, operation);
+}
+
+void benchmarkSize(const BoardSize& size, const Textures& textures, vector<Result>& results) {
+    cerr << size.name << " (" << size.rows << "x" << size.cols << ", " << size.mines << " mines)" << endl;
+    uint64_t seed = 1;
+
+    results.push_back(measure("board_construction", size, [&]() {
+        Board board(size.rows, size.cols, size.mines);
+        board.placeMines(seed++);
+    }));
+
+    Board board(size.rows, size.cols, size.mines);
+    board.placeMines(seed);
+    results.push_back(measure("count_adjacent_mines", size, [&]() { board.countAdjacentMines(); }));
+
+    Game game(size.rows, size.cols, size.mines);
+    game.trackChanges = false;
+    results.push_back(measure("flood_fill_reveal", size,
+        [&]() {
+            game.reset(seed++);
+            game.placeMines(size.rows / 2, size.cols / 2);
+        },
+        [&]() { game.reveal(size.rows / 2, size.cols / 2); }));
+
+    auto newGame = [&]() {
+        game.reset(seed++);
+        game.reveal(size.rows / 2, size.cols / 2);
+    };
+    newGame();
+    results.push_back(measure("game_reset", size, newGame));
+
+    // The screen, with its results saved to temporary files instead of the real leaderboard
+    int width = min(size.cols * 32, 1280);
+    int height = min(size.rows * 32, 800) + 100;
+    filesystem::path temporary = filesystem::temp_directory_path();
+    string scoresPath = (temporary / "bench_scores.log").string();
+    string leaderboardPath = (temporary / "bench_leaderboard.txt").string();
+    filesystem::remove(scoresPath);
+    filesystem::remove(leaderboardPath);
+    {
+        sf::RenderTexture unused;
+        GameScreen gameScreen(unused, width, height, size.rows, size.cols, size.mines, textures, false, scoresPath, leaderboardPath);
+        gameScreen.name = "bench|";
+        gameScreen.floodFillReveal(size.rows / 2, size.cols / 2);
+        gameScreen.isNewGame = false;
+        gameScreen.unpause();
+
+        results.push_back(measure("renderer_rebuild", size, [&]() {
+            gameScreen.boardRenderer.invalidate();
+            gameScreen.boardRenderer.update(gameScreen.game, false, false);
+        }));
+
+        long long stored = 0;
+        results.push_back(measure("store_result", size,
+            [&]() {
+                // Let the writer catch up now and then, outside the measurement, so the queue stays small
+                if (++stored % 256 == 0) {
+                    gameScreen.scoreStore.flush();
+                }
+            },
+            [&]() { gameScreen.storeResult(83); }));
+        gameScreen.scoreStore.flush();
+
+        results.push_back(measure("update_timer", size, [&]() { gameScreen.updateTimer(); }));
+
+        gameScreen.reset();
+        results.push_back(measure("screen_reset", size, [&]() { gameScreen.reset(); }));
+
+        unsigned int maxSize = sf::Texture::getMaximumSize();
+        sf::RenderTexture target;
+        if ((unsigned int)width <= maxSize && (unsigned int)height <= maxSize && target.create(width, height)) {
+            results.push_back(measure("frame", size, [&]() {
+                target.clear(sf::Color::White);
+                gameScreen.drawToScreen(target);
+                target.display();
+            }));
+        }
+        else {
+            cerr << "  frame: skipped, " << width << "x" << height << " is larger than the maximum texture size " << maxSize << endl;
+        }
+    }
+    filesystem::remove(scoresPath);
+    filesystem::remove(leaderboardPath);
+}
+
+string toJson(const vector<Result>& results) {
+    ostringstream json;
+    json << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& result = results[i];
+        json << "    {\"name\": \"" << result.name << "\", \"size\": \"" << result.size.name << "\", \"rows\": "
+             << result.size.rows << ", \"cols\": " << result.size.cols << ", \"mines\": " << result.size.mines
+             << ", \"iterations\": " << result.iterations << ", \"ns_per_op\": " << result.nanoseconds
+             << ", \"allocs_per_op\": " << result.allocations << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+    return json.str();
+}
+
+int main(int argc, char* argv[]) {
+    Textures textures;
+    vector<BoardSize> sizes = {
+        {"beginner", 9, 9, 10},
+        {"intermediate", 16, 16, 40},
+        {"expert", 16, 30, 99},
+        {"1000x1000", 1000, 1000, 206250},
+    };
+
+    vector<Result> results;
+    for (const BoardSize& size : sizes) {
+        benchmarkSize(size, textures, results);
+    }
+
+    // Resetting must reuse the storage of the previous game, and the timer runs every frame
+    bool hotPathAllocated = false;
+    for (const Result& result : results) {
+        bool mustNotAllocate = result.name == "game_reset" || result.name == "screen_reset" || result.name == "update_timer";
+        if (mustNotAllocate && result.allocations > 0) {
+            cerr << "Error: " << result.name << " allocates on the " << result.size.name << " board." << endl;
+            hotPathAllocated = true;
+        }
+    }
+
+    string json = toJson(results);
+    if (argc > 1) {
+        ofstream outfile(argv[1]);
+        if (!outfile) {
+            cout << "Error: " << argv[1] << " cannot open in write mode." << endl;
+            return 1;
+        }
+        outfile << json;
+    }
+    else {
+        cout << json;
+    }
+    return hotPathAllocated ? 1 : 0;
+}
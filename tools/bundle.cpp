@@ -0,0 +1,50 @@
+// Packs the images and the font into one asset bundle (textures.h), which the game loads at startup with
+// no PNG decoding. Run it from the directory holding files/ whenever an image or the font changes.
+// With a header path it also writes the bundle as a C++ array, to compile the assets into the game:
+//   g++ -std=c++17 -O2 -DMINESWEEPER_EMBEDDED_ASSETS -I. main.cpp ...
+// where the header is assetbundle.h next to textures.h.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/bundle.cpp -o bundle -lsfml-graphics -lsfml-window -lsfml-system -pthread
+// Usage: bundle [bundle file] [header file]
+#include <SFML/Graphics.hpp>
+#include "textures.h"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    string bundlePath = argc > 1 ? argv[1] : "files/assets.bundle";
+    string headerPath = argc > 2 ? argv[2] : "";
+
+    Textures textures(false);
+    if (!textures.loaded || !textures.writeBundle(bundlePath)) {
+        cout << "Error: cannot write " << bundlePath << "." << endl;
+        return 1;
+    }
+
+    ifstream infile(bundlePath, ios::binary);
+    vector<unsigned char> bundle((istreambuf_iterator<char>(infile)), istreambuf_iterator<char>());
+    cout << "Wrote " << bundlePath << ", " << bundle.size() << " bytes." << endl;
+    if (headerPath.empty()) {
+        return 0;
+    }
+
+    ofstream header(headerPath);
+    header << "#pragma once\n// Generated by tools/bundle.cpp from " << bundlePath << ". Do not edit.\n\n"
+           << "alignas(16) static const unsigned char ASSET_BUNDLE[" << bundle.size() << "] = {";
+    for (size_t i = 0; i < bundle.size(); i++) {
+        header << (i % 24 == 0 ? "\n    " : " ") << (int)bundle[i] << ",";
+    }
+    header << "\n};\n";
+    if (!header) {
+        cout << "Error: cannot write " << headerPath << "." << endl;
+        return 1;
+    }
+    cout << "Wrote " << headerPath << "." << endl;
+    return 0;
+}
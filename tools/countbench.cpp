@@ -0,0 +1,132 @@
+// Microbenchmark of adjacent mine counting: the old pointer-chasing per-tile loop, a per-tile loop over the
+// flat board, and the bitboard adder network used by Board::countAdjacentMines.
+//
+// Build from the repository root (add -mavx2 or -march=native for the AVX2 path):
+//   g++ -std=c++17 -O2 -I. tools/countbench.cpp -o countbench
+// Usage: countbench [repetitions]
+#include "board.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// A tile as it was stored before the flat board: heap allocated, with pointers to its neighbors.
+struct PointerTile {
+    bool mined = false;
+    int adjacentMineCount = 0;
+    vector<PointerTile*> adjacentTiles = vector<PointerTile*>(8, nullptr);
+};
+
+// The old per-tile loop, walking each tile's neighbor pointers
+void countWithPointers(vector<vector<PointerTile*>>& tiles) {
+    for (auto& row : tiles) {
+        for (PointerTile* tile : row) {
+            tile->adjacentMineCount = 0;
+            for (PointerTile* neighbor : tile->adjacentTiles) {
+                if (neighbor != nullptr && neighbor->mined) {
+                    tile->adjacentMineCount++;
+                }
+            }
+        }
+    }
+}
+
+// A per-tile loop over the flat board with index offsets
+void countPerTile(Board& board) {
+    for (int row = 0; row < board._rows; row++) {
+        int start = board.index(row, 0);
+        for (int i = start; i < start + board._cols; i++) {
+            int count = 0;
+            for (int offset : board.neighborOffsets) {
+                count += board.tiles[i + offset].isMined();
+            }
+            board.tiles[i].setAdjacentMineCount(count);
+        }
+    }
+}
+
+bool operator==(const Tile& a, const Tile& b) {
+    return a.bits == b.bits;
+}
+
+// Runs the function repetitions times and returns nanoseconds per tile
+template <typename Count>
+double timePerTile(long long tiles, int repetitions, Count count) {
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; i++) {
+        count();
+    }
+    double nanoseconds = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    return nanoseconds / ((double)tiles * repetitions);
+}
+
+void benchmark(const string& name, int rows, int cols, int mines, int repetitions) {
+    Board board(rows, cols, mines);
+    board.placeMines(1);
+    long long tiles = (long long)rows * cols;
+
+    // Build the pointer grid with the same mine layout
+    vector<vector<PointerTile*>> pointerTiles(rows, vector<PointerTile*>(cols));
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            pointerTiles[row][col] = new PointerTile();
+            pointerTiles[row][col]->mined = board.tileAt(row, col).isMined();
+        }
+    }
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            int slot = 0;
+            for (int dr = -1; dr <= 1; dr++) {
+                for (int dc = -1; dc <= 1; dc++) {
+                    if (dr == 0 && dc == 0) {
+                        continue;
+                    }
+                    int r = row + dr;
+                    int c = col + dc;
+                    if (r >= 0 && r < rows && c >= 0 && c < cols) {
+                        pointerTiles[row][col]->adjacentTiles[slot] = pointerTiles[r][c];
+                    }
+                    slot++;
+                }
+            }
+        }
+    }
+
+    double pointerTime = timePerTile(tiles, repetitions, [&]() { countWithPointers(pointerTiles); });
+    double perTileTime = timePerTile(tiles, repetitions, [&]() { countPerTile(board); });
+    vector<Tile> expected = board.tiles;
+    double bitboardTime = timePerTile(tiles, repetitions, [&]() { board.countAdjacentMines(); });
+
+    // The three methods must agree
+    bool matches = board.tiles == expected;
+    for (int row = 0; row < rows && matches; row++) {
+        for (int col = 0; col < cols && matches; col++) {
+            matches = pointerTiles[row][col]->adjacentMineCount == board.tileAt(row, col).adjacentMineCount();
+        }
+    }
+
+    cout << name << " (" << rows << "x" << cols << ", " << mines << " mines)" << (matches ? "" : "  COUNTS DIFFER") << endl;
+    cout << "  pointer per-tile loop: " << pointerTime << " ns/tile" << endl;
+    cout << "  flat per-tile loop:    " << perTileTime << " ns/tile" << endl;
+    cout << "  bitboard:              " << bitboardTime << " ns/tile (" << pointerTime / bitboardTime << "x)" << endl;
+
+    for (auto& row : pointerTiles) {
+        for (PointerTile* tile : row) {
+            delete tile;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int repetitions = argc > 1 ? stoi(argv[1]) : 20;
+#if defined(__AVX2__)
+    cout << "Bitboard path: AVX2" << endl;
+#else
+    cout << "Bitboard path: scalar 64-bit words" << endl;
+#endif
+    benchmark("Expert", 16, 30, 99, repetitions * 10000);
+    benchmark("1000x1000", 1000, 1000, 206250, repetitions);
+    return 0;
+}
@@ -0,0 +1,149 @@
+// Explores an endless board far from the origin and reports the speed of the reveals and the memory the
+// board holds as it goes, which should stay bounded by the resident chunks plus 2 bits per changed tile.
+// The explorer knows where the mines are, so it never loses: it sweeps a band of rows to the right,
+// revealing every safe tile it has not seen yet. It then checks a sample of tiles, across chunk edges and
+// in chunks that were evicted and rebuilt, against counts computed directly from the mine generator.
+// Then, on a sparse board where every reveal floods as far as it may, it walks out along one row and back
+// along another, so floods stop, are evicted and spilled, and resume; every empty tile near where it ends
+// must have had its neighbors revealed. Few packed chunks are kept in memory, so both parts spill.
+// The chunks in memory must never be more than MAX_RESIDENT_CHUNKS after a reveal. Exits with 1 if they
+// are, if the explorer hits a mine or if a checked tile is wrong.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/endlessbench.cpp -o endlessbench
+// Usage: endlessbench [columns] [band rows] [mine density]
+#include "endless.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// Whether a tile is mined, straight from the generator
+bool generatedMine(const EndlessBoard& board, int row, int col) {
+    uint32_t mines[EndlessBoard::CHUNK_SIZE];
+    board.generateMines(row >> EndlessBoard::CHUNK_SHIFT, col >> EndlessBoard::CHUNK_SHIFT, mines);
+    return (mines[row & EndlessBoard::CHUNK_MASK] >> (col & EndlessBoard::CHUNK_MASK)) & 1;
+}
+
+const size_t PACKED_CHUNKS_IN_MEMORY = 1024;
+const double SPARSE_DENSITY = 0.02;
+const int WALK_STEPS = 160;     // Reveals each way
+const int WALK_STRIDE = 64;     // Columns between reveals
+const int RETURN_ROW = 200;
+
+// Walks the sparse board and returns how many empty tiles near the end still have a neighbor to reveal
+long long checkFloodWalk(size_t& peakResident) {
+    EndlessGame game(SPARSE_DENSITY, 2);
+    game.trackChanges = false;
+    game.board.maxPackedChunks = PACKED_CHUNKS_IN_MEMORY;
+    int row = 0;
+    int col = 0;
+    for (int step = 0; step < 2 * WALK_STEPS && !game.gameLost; step++) {
+        row = step < WALK_STEPS ? 0 : RETURN_ROW;
+        col = (step < WALK_STEPS ? step : 2 * WALK_STEPS - 1 - step) * WALK_STRIDE;
+        // Reveal the nearest safe tile
+        while (game.board.tileAt(row, col).isMined()) {
+            col++;
+        }
+        game.reveal(row, col);
+        peakResident = max(peakResident, game.board.chunks.size());
+    }
+    if (game.gameLost) {
+        cout << "Error: the walk hit a mine at " << game.lostCell.row << ", " << game.lostCell.col << endl;
+        return 1;
+    }
+    cout << "walk: " << game.tilesRevealed << " tiles revealed, " << game.board.chunks.size() << " chunks resident, "
+         << game.board.packedChunks.size() << " packed, " << game.board.spilledChunks.size() << " spilled, "
+         << game.board.floodPendingChunks << " with a flood pending" << endl;
+
+    long long open = 0;
+    int reach = EndlessGame::FLOOD_RADIUS - 1;
+    for (int r = row - reach; r <= row + reach; r++) {
+        for (int c = col - reach; c <= col + reach; c++) {
+            const Tile& tile = game.board.tileAt(r, c);
+            if (!tile.isRevealed() || tile.adjacentMineCount() != 0) {
+                continue;
+            }
+            for (int dr = -1; dr <= 1; dr++) {
+                for (int dc = -1; dc <= 1; dc++) {
+                    if (!game.board.tileAt(r + dr, c + dc).isRevealed()) {
+                        open++;
+                        dr = dc = 2;
+                    }
+                }
+            }
+        }
+    }
+    return open;
+}
+
+int main(int argc, char* argv[]) {
+    int columns = argc > 1 ? stoi(argv[1]) : 100000;
+    int bandRows = argc > 2 ? stoi(argv[2]) : 64;
+    double density = argc > 3 ? stod(argv[3]) : 0.16;
+
+    EndlessGame game(density, 1);
+    game.trackChanges = false;
+    game.board.maxPackedChunks = PACKED_CHUNKS_IN_MEMORY;
+    game.reveal(0, 0);
+
+    long long reveals = 0;
+    size_t peakBytes = 0;
+    size_t peakResident = game.board.chunks.size();
+    auto start = chrono::steady_clock::now();
+    for (int col = 0; col < columns; col++) {
+        for (int row = -bandRows / 2; row < bandRows / 2; row++) {
+            const Tile& tile = game.board.tileAt(row, col);
+            if (!tile.isMined() && !tile.isRevealed()) {
+                game.reveal(row, col);
+                reveals++;
+                peakResident = max(peakResident, game.board.chunks.size());
+            }
+        }
+        peakBytes = max(peakBytes, game.board.memoryBytes());
+        if ((col + 1) % (columns / 10 > 0 ? columns / 10 : 1) == 0) {
+            cout << "column " << col + 1 << ": " << game.tilesRevealed << " tiles revealed, "
+                 << game.board.chunks.size() << " chunks resident, " << game.board.packedChunks.size()
+                 << " packed, " << game.board.spilledChunks.size() << " spilled, " << game.board.memoryBytes() / 1024
+                 << " KB" << endl;
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (game.gameLost) {
+        cout << "Error: the explorer hit a mine at " << game.lostCell.row << ", " << game.lostCell.col << endl;
+        return 1;
+    }
+
+    // Sample tiles on and around chunk edges, most of them in chunks that were evicted and rebuilt
+    long long checked = 0;
+    long long wrong = 0;
+    for (int col = 0; col < columns; col += 7) {
+        for (int row = -bandRows / 2; row < bandRows / 2; row += 5) {
+            int expected = 0;
+            for (int dr = -1; dr <= 1; dr++) {
+                for (int dc = -1; dc <= 1; dc++) {
+                    expected += (dr != 0 || dc != 0) && generatedMine(game.board, row + dr, col + dc);
+                }
+            }
+            const Tile& tile = game.board.tileAt(row, col);
+            bool mined = generatedMine(game.board, row, col);
+            wrong += tile.adjacentMineCount() != expected || tile.isMined() != mined || tile.isRevealed() == mined;
+            checked++;
+        }
+    }
+
+    cout << game.tilesRevealed << " tiles revealed over " << (long long)columns * bandRows << " cells in "
+         << reveals << " reveals, " << seconds * 1e6 / reveals << " us per reveal" << endl;
+    cout << game.board.chunksCreated << " chunks created, peak " << peakBytes / 1024 << " KB, "
+         << (double)game.board.memoryBytes() / game.tilesRevealed << " bytes per revealed tile at the end" << endl;
+    cout << checked << " tiles checked, " << wrong << " wrong" << endl;
+
+    long long open = checkFloodWalk(peakResident);
+    cout << open << " empty tiles near the end of the walk with a neighbor left to reveal" << endl;
+    cout << "peak " << peakResident << " chunks resident, at most " << EndlessBoard::MAX_RESIDENT_CHUNKS << endl;
+    if (peakResident > (size_t)EndlessBoard::MAX_RESIDENT_CHUNKS) {
+        cout << "Error: more chunks were resident than MAX_RESIDENT_CHUNKS." << endl;
+    }
+    return wrong == 0 && open == 0 && peakResident <= (size_t)EndlessBoard::MAX_RESIDENT_CHUNKS ? 0 : 1;
+}
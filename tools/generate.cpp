@@ -0,0 +1,113 @@
+// Generates boards in bulk on every core and writes them to a compact binary file.
+// Board i is placed from Rng::stream(seed, i), so the output does not depend on the number of threads.
+//
+// File layout (little-endian):
+//   char[4] "MSBD", uint32 version, uint32 rows, uint32 cols, uint32 mines, uint64 count, uint64 seed
+//   then count boards, each the mine layout as ceil(rows * cols / 8) bytes, row-major, bit i % 8 of byte i / 8.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/generate.cpp -o generate -pthread
+// Usage: generate rows cols mines count seed [output file] [threads]
+#include "board.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Boards generated between writes, so memory stays bounded for any count
+const uint64_t BOARDS_PER_BATCH = 1 << 16;
+
+void writeValue(FILE* file, const void* value, size_t size) {
+    fwrite(value, size, 1, file);
+}
+
+// Generates boards first to last into out, reusing one board for all of them.
+void generateRange(Board& board, int mines, uint64_t seed, uint64_t first, uint64_t last, uint8_t* out, size_t boardBytes) {
+    for (uint64_t i = first; i < last; i++) {
+        board.clearMines(mines);
+        board.placeMines(Rng::stream(seed, i));
+
+        uint8_t* bits = out + (i - first) * boardBytes;
+        memset(bits, 0, boardBytes);
+        for (int index : board.mineIndices) {
+            int position = board.rowOf(index) * board._cols + board.colOf(index);
+            bits[position / 8] |= (uint8_t)(1 << (position % 8));
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 6) {
+        cout << "Usage: generate rows cols mines count seed [output file] [threads]" << endl;
+        return 1;
+    }
+    int rows = stoi(argv[1]);
+    int cols = stoi(argv[2]);
+    int mines = stoi(argv[3]);
+    uint64_t count = stoull(argv[4]);
+    uint64_t seed = stoull(argv[5]);
+    string path = argc > 6 ? argv[6] : "boards.bin";
+    int threads = argc > 7 ? stoi(argv[7]) : (int)thread::hardware_concurrency();
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (rows < 1 || cols < 1 || mines < 0 || mines >= rows * cols) {
+        cout << "Invalid board size or mine count." << endl;
+        return 1;
+    }
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        cout << "Error: " << path << " cannot open in write mode." << endl;
+        return 1;
+    }
+    uint32_t version = 1;
+    uint32_t header[4] = {version, (uint32_t)rows, (uint32_t)cols, (uint32_t)mines};
+    writeValue(file, "MSBD", 4);
+    writeValue(file, header, sizeof(header));
+    writeValue(file, &count, sizeof(count));
+    writeValue(file, &seed, sizeof(seed));
+
+    size_t boardBytes = ((size_t)rows * cols + 7) / 8;
+    vector<uint8_t> buffer(min(count, BOARDS_PER_BATCH) * boardBytes);
+
+    // One reusable board per thread
+    vector<Board> boards(threads, Board(rows, cols, mines));
+
+    auto start = chrono::steady_clock::now();
+    for (uint64_t batchStart = 0; batchStart < count; batchStart += BOARDS_PER_BATCH) {
+        uint64_t batchEnd = min(count, batchStart + BOARDS_PER_BATCH);
+        uint64_t batchSize = batchEnd - batchStart;
+
+        vector<thread> workers;
+        for (int t = 0; t < threads; t++) {
+            uint64_t first = batchStart + batchSize * t / threads;
+            uint64_t last = batchStart + batchSize * (t + 1) / threads;
+            uint8_t* out = buffer.data() + (first - batchStart) * boardBytes;
+            workers.emplace_back(generateRange, ref(boards[t]), mines, seed, first, last, out, boardBytes);
+        }
+        for (thread& worker : workers) {
+            worker.join();
+        }
+
+        fwrite(buffer.data(), boardBytes, batchSize, file);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (fclose(file) != 0) {
+        cout << "Error writing " << path << "." << endl;
+        return 1;
+    }
+
+    double perSecond = count / seconds;
+    cout << "Generated " << count << " boards (" << rows << "x" << cols << ", " << mines << " mines) into " << path
+         << " in " << seconds << " s" << endl;
+    cout << perSecond << " boards/s on " << threads << " threads, " << perSecond / threads << " boards/s per core" << endl;
+    return 0;
+}
@@ -0,0 +1,190 @@
+// Load generator for the game server (tools/server.cpp). Opens a number of connections, creates the
+// sessions spread over them, then plays random moves in random sessions for a while: reveals, flags and
+// diffs, and a new game in place once a game is over. Each connection keeps one request in flight and
+// times it from sending to the whole response, and the latencies of all connections are summarized.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/loadgen.cpp -o loadgen -pthread
+// Usage: loadgen [address] [sessions] [connections] [seconds] [rows] [cols] [mines]
+#include "server.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+struct BoardSize {
+    int rows;
+    int cols;
+    int mines;
+};
+
+// One connection to the server and the sessions it plays
+class Client {
+public:
+    int fd = -1;
+    vector<uint64_t> sessions;
+    vector<uint8_t> gameOver;           // Per session, whether its last move ended the game
+    vector<uint32_t> latencies;         // Nanoseconds per request
+    long long errors = 0;
+    vector<uint8_t> request;
+    vector<uint8_t> response;
+
+    // Sends a request and waits for its response. Returns false if the connection failed.
+    bool call(uint8_t type, uint64_t session, const uint32_t* arguments, int argumentCount, uint64_t seed = 0) {
+        request.clear();
+        size_t start = beginMessage(request);
+        putU8(request, type);
+        putU64(request, session);
+        for (int i = 0; i < argumentCount; i++) {
+            putU32(request, arguments[i]);
+        }
+        if (type == SERVER_NEW_GAME) {
+            putU64(request, seed);
+        }
+        endMessage(request, start);
+
+        auto sent = chrono::steady_clock::now();
+        if (!sendAll(request.data(), request.size())) {
+            return false;
+        }
+        uint8_t header[4];
+        if (!receiveAll(header, 4)) {
+            return false;
+        }
+        response.resize(getU32(header));
+        if (!receiveAll(response.data(), response.size())) {
+            return false;
+        }
+        latencies.push_back((uint32_t)min<long long>(
+            chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - sent).count(), UINT32_MAX));
+        if (response.size() < 2 || response[0] != SERVER_OK) {
+            errors++;
+        }
+        return true;
+    }
+
+private:
+    bool sendAll(const uint8_t* data, size_t size) {
+        while (size > 0) {
+            ssize_t sent = write(fd, data, size);
+            if (sent <= 0) {
+                return false;
+            }
+            data += sent;
+            size -= (size_t)sent;
+        }
+        return true;
+    }
+
+    bool receiveAll(uint8_t* data, size_t size) {
+        while (size > 0) {
+            ssize_t received = read(fd, data, size);
+            if (received <= 0) {
+                return false;
+            }
+            data += received;
+            size -= (size_t)received;
+        }
+        return true;
+    }
+};
+
+// Creates the client's sessions, then plays until the deadline. Returns false if the connection failed.
+bool play(Client& client, int sessionCount, BoardSize board, chrono::steady_clock::time_point deadline, uint64_t seed) {
+    Rng rng(seed);
+    uint32_t size[3] = {(uint32_t)board.rows, (uint32_t)board.cols, (uint32_t)board.mines};
+    for (int i = 0; i < sessionCount; i++) {
+        if (!client.call(SERVER_NEW_GAME, 0, size, 3) || client.response.size() < 10) {
+            return false;
+        }
+        client.sessions.push_back(getU64(client.response.data() + 2));
+        client.gameOver.push_back(0);
+    }
+    client.latencies.clear();       // Only moves are measured
+
+    while (chrono::steady_clock::now() < deadline) {
+        size_t session = (size_t)rng.below(client.sessions.size());
+        uint64_t id = client.sessions[session];
+        if (client.gameOver[session]) {
+            if (!client.call(SERVER_NEW_GAME, id, size, 3)) {
+                return false;
+            }
+            client.gameOver[session] = 0;
+            continue;
+        }
+
+        uint64_t action = rng.below(10);
+        uint32_t tile[2] = {(uint32_t)rng.below((uint64_t)board.rows), (uint32_t)rng.below((uint64_t)board.cols)};
+        uint8_t type = action < 6 ? SERVER_REVEAL : action < 8 ? SERVER_FLAG : SERVER_DIFF;
+        if (!client.call(type, id, tile, type == SERVER_DIFF ? 0 : 2)) {
+            return false;
+        }
+        if (type != SERVER_DIFF && client.response.size() >= 3 && client.response[2] != 0) {
+            client.gameOver[session] = 1;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    string address = argc > 1 ? argv[1] : "7878";
+    int sessions = argc > 2 ? stoi(argv[2]) : 10000;
+    int connections = argc > 3 ? stoi(argv[3]) : 16;
+    double seconds = argc > 4 ? stod(argv[4]) : 10;
+    BoardSize board;
+    board.rows = argc > 5 ? stoi(argv[5]) : 16;
+    board.cols = argc > 6 ? stoi(argv[6]) : 30;
+    board.mines = argc > 7 ? stoi(argv[7]) : 99;
+
+    vector<Client> clients(connections);
+    for (Client& client : clients) {
+        client.fd = openSocket(address, false);
+        if (client.fd < 0) {
+            cout << "Error: cannot connect to " << address << "." << endl;
+            return 1;
+        }
+    }
+
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds((long long)(seconds * 1000));
+    vector<thread> threads;
+    vector<int> failed(connections, 0);
+    for (int i = 0; i < connections; i++) {
+        int share = sessions / connections + (i < sessions % connections ? 1 : 0);
+        threads.emplace_back([&, i, share]() {
+            failed[i] = !play(clients[i], share, board, deadline, Rng::stream(1, (uint64_t)i));
+        });
+    }
+    for (thread& worker : threads) {
+        worker.join();
+    }
+
+    vector<uint32_t> latencies;
+    long long errors = 0;
+    int failedConnections = 0;
+    for (int i = 0; i < connections; i++) {
+        latencies.insert(latencies.end(), clients[i].latencies.begin(), clients[i].latencies.end());
+        errors += clients[i].errors;
+        failedConnections += failed[i];
+        close(clients[i].fd);
+    }
+    if (latencies.empty()) {
+        cout << "Error: no requests completed." << endl;
+        return 1;
+    }
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double fraction) {
+        size_t rank = (size_t)(fraction * (double)(latencies.size() - 1));
+        return latencies[rank] / 1000.0;
+    };
+
+    cout << sessions << " sessions over " << connections << " connections: " << latencies.size() << " requests in "
+         << seconds << " s, " << (long long)(latencies.size() / seconds) << " requests/s" << endl;
+    cout << "latency p50 " << percentile(0.50) << " us, p99 " << percentile(0.99) << " us, p99.9 "
+         << percentile(0.999) << " us, max " << latencies.back() / 1000.0 << " us" << endl;
+    cout << errors << " error responses, " << failedConnections << " connections failed" << endl;
+    return errors == 0 && failedConnections == 0 ? 0 : 1;
+}
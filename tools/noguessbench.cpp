@@ -0,0 +1,109 @@
+// Measures no-guess board generation (noguess.h). Places boards through Game with noGuess set, clicking the
+// middle first, and reports the time per board and the repairs it took. Every board is then played by a
+// fresh solver from the first click, which must reveal every safe tile without a guess.
+// For comparison it also reports how often an ordinary board with the same open first click can be solved
+// without guessing, and the time per board of placing and solving ordinary boards until one can.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/noguessbench.cpp -o noguessbench
+// Usage: noguessbench [boards] [rows] [cols] [mines] [seed]
+#include "game.h"
+#include "solver.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Plays the game from the first click revealing only deduced safe tiles. Returns true if it is won.
+bool solvesWithoutGuessing(Game& game, Solver& solver, int row, int col) {
+    solver.reset(game.board);
+    solver.notifyRevealed(game.reveal(row, col));
+    size_t safeTaken = 0;
+    while (!game.isOver()) {
+        solver.solve();
+        int next = -1;
+        while (safeTaken < solver.safeTiles.size() && next < 0) {
+            int index = solver.safeTiles[safeTaken++];
+            if (!game.board.tiles[index].isRevealed()) {
+                next = index;
+            }
+        }
+        if (next < 0) {
+            return false;
+        }
+        solver.notifyRevealed(game.reveal(game.board.rowOf(next), game.board.colOf(next)));
+    }
+    return game.gameWon;
+}
+
+int main(int argc, char* argv[]) {
+    int boards = argc > 1 ? stoi(argv[1]) : 1000;
+    int rows = argc > 2 ? stoi(argv[2]) : 16;
+    int cols = argc > 3 ? stoi(argv[3]) : 30;
+    int mines = argc > 4 ? stoi(argv[4]) : 99;
+    uint64_t seed = argc > 5 ? stoull(argv[5]) : 1;
+    int row = rows / 2;
+    int col = cols / 2;
+
+    Game game(rows, cols, mines, seed);
+    game.trackChanges = false;
+    game.noGuess = true;
+    Game check(rows, cols, mines, seed);
+    check.trackChanges = false;
+    check.safeNeighborhood = true;
+    Solver solver;
+
+    vector<double> times;       // Milliseconds per board
+    long long repairs = 0;
+    long long passes = 0;
+    long long attempts = 0;
+    int failures = 0;           // Boards with no no-guess layout found
+    int wrong = 0;              // Boards the solver could not finish
+    for (int i = 0; i < boards; i++) {
+        game.reset(Rng::stream(seed, (uint64_t)i));
+        auto start = chrono::steady_clock::now();
+        game.placeMines(row, col);
+        times.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+        const NoGuessGenerator& generator = game.noGuessGenerator;
+        failures += !generator.solved;
+        repairs += generator.repairs;
+        passes += generator.passes;
+        attempts += generator.attempts;
+
+        wrong += !solvesWithoutGuessing(game, solver, row, col);
+    }
+
+    // Ordinary boards: how many can be solved, and the cost of drawing them until one can
+    int solvable = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < boards; i++) {
+        check.reset(Rng::stream(seed, (uint64_t)i));
+        solvable += solvesWithoutGuessing(check, solver, row, col);
+    }
+    double ordinaryMilliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    sort(times.begin(), times.end());
+    double sum = 0;
+    for (double time : times) {
+        sum += time;
+    }
+    auto percentile = [&](double p) { return times[(size_t)(p * (times.size() - 1))]; };
+
+    cout << rows << "x" << cols << ", " << mines << " mines, " << boards << " no-guess boards"
+         << (wrong ? "  BOARDS NEED GUESSES" : "") << endl;
+    cout << "  time:     mean " << sum / boards << " ms, median " << percentile(0.5) << " ms, p99 " << percentile(0.99)
+         << " ms, max " << times.back() << " ms" << endl;
+    cout << "  repairs:  " << (double)repairs / boards << " per board, " << (double)passes / boards << " passes, "
+         << (double)attempts / boards << " placements" << endl;
+    cout << "  solved without guessing: " << boards - wrong << " of " << boards << ", " << failures
+         << " gave up" << endl;
+    cout << "  ordinary boards solvable: " << 100.0 * solvable / boards << "%";
+    if (solvable > 0) {
+        cout << ", drawing until one is takes " << ordinaryMilliseconds / solvable << " ms per board";
+    }
+    cout << endl;
+    return wrong == 0 ? 0 : 1;
+}
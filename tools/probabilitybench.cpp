@@ -0,0 +1,99 @@
+// Plays expert games with the constraint solver and, when it is stuck, the exact probability engine.
+// Each time nothing is certain the engine computes the probability of every hidden tile and the safest one
+// is revealed. Reports the time per probability computation and the win rate.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/probabilitybench.cpp -o probabilitybench -pthread
+// Usage: probabilitybench [games] [seed] [threads]
+#include "game.h"
+#include "probability.h"
+#include "solver.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    int games = argc > 1 ? stoi(argv[1]) : 2000;
+    uint64_t seed = argc > 2 ? stoull(argv[2]) : 1;
+    int threads = argc > 3 ? stoi(argv[3]) : (int)thread::hardware_concurrency();
+
+    Game game(16, 30, 99);
+    game.trackChanges = false;
+    Solver solver;
+    ProbabilityEngine engine(threads);
+    vector<double> times;       // Milliseconds per probability computation
+    int wins = 0;
+    int failures = 0;
+
+    for (int g = 0; g < games; g++) {
+        game.reset(Rng::stream(seed, g));
+        solver.reset(game.board);
+        size_t safeTaken = 0;
+
+        int next = game.board.index(game.rows() / 2, game.cols() / 2);
+        while (!game.isOver()) {
+            solver.notifyRevealed(game.reveal(game.board.rowOf(next), game.board.colOf(next)));
+            solver.solve();
+
+            next = -1;
+            while (safeTaken < solver.safeTiles.size() && next < 0) {
+                int index = solver.safeTiles[safeTaken++];
+                if (!game.board.tiles[index].isRevealed()) {
+                    next = index;
+                }
+            }
+            if (next >= 0 || game.isOver()) {
+                continue;
+            }
+
+            // Mines the solver found are flagged so the engine sees them
+            for (int index : solver.mineTiles) {
+                if (!game.board.tiles[index].isFlagged()) {
+                    game.toggleFlag(game.board.rowOf(index), game.board.colOf(index));
+                }
+            }
+
+            auto start = chrono::steady_clock::now();
+            bool consistent = engine.compute(game.board);
+            times.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+            if (!consistent) {
+                failures++;
+                break;
+            }
+
+            double safest = 2.0;
+            for (int row = 0; row < game.rows(); row++) {
+                for (int col = 0; col < game.cols(); col++) {
+                    int index = game.board.index(row, col);
+                    const Tile& tile = game.board.tiles[index];
+                    if (!tile.isRevealed() && !tile.isFlagged() && engine.probability[index] < safest) {
+                        safest = engine.probability[index];
+                        next = index;
+                    }
+                }
+            }
+        }
+        wins += game.gameWon;
+    }
+
+    sort(times.begin(), times.end());
+    double sum = 0;
+    for (double time : times) {
+        sum += time;
+    }
+    auto percentile = [&](double p) { return times.empty() ? 0.0 : times[(size_t)(p * (times.size() - 1))]; };
+
+    cout << "Expert (16x30, 99 mines), " << games << " games, " << threads << " threads"
+         << (failures ? "  INCONSISTENT POSITIONS" : "") << endl;
+    cout << "  probability computations: " << times.size() << endl;
+    cout << "  mean:   " << (times.empty() ? 0.0 : sum / times.size()) << " ms" << endl;
+    cout << "  median: " << percentile(0.5) << " ms" << endl;
+    cout << "  p99:    " << percentile(0.99) << " ms" << endl;
+    cout << "  max:    " << (times.empty() ? 0.0 : times.back()) << " ms" << endl;
+    cout << "  win rate: " << 100.0 * wins / games << "%" << endl;
+    return 0;
+}
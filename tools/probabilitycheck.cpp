@@ -0,0 +1,171 @@
+// Checks the probability engine (probability.h) against brute force on small boards. Random games are played
+// with safe reveals and flags, some of them wrong, and at every position every placement of the remaining
+// mines among the hidden tiles is tried. The mine probability of each tile over the placements that match
+// every revealed number must equal the engine's, and the engine must fail exactly when no placement matches.
+// Exits with 1 if any check fails.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/probabilitycheck.cpp -o probabilitycheck -pthread
+// Usage: probabilitycheck [games] [seed] [threads]
+#include "game.h"
+#include "probability.h"
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const double TOLERANCE = 1e-9;
+
+// Counts every placement of the remaining mines that matches what is visible, and how many of them put a
+// mine on each tile
+class BruteForce {
+public:
+    double layouts = 0;
+    vector<double> mined;       // Placements with a mine on each tile index
+
+    void count(const Board& board) {
+        board_ = &board;
+        layouts = 0;
+        mined.assign(board.tiles.size(), 0.0);
+        hidden.clear();
+        numbers.clear();
+        int remaining = board._mines;
+        for (int row = 0; row < board._rows; row++) {
+            for (int col = 0; col < board._cols; col++) {
+                int index = board.index(row, col);
+                const Tile& tile = board.tiles[index];
+                remaining -= tile.isFlagged();
+                if (!tile.isRevealed() && !tile.isFlagged()) {
+                    hidden.push_back(index);
+                }
+                else if (tile.isRevealed()) {
+                    numbers.push_back(index);
+                }
+            }
+        }
+        minedNow.assign(board.tiles.size(), false);
+        if (remaining >= 0) {
+            place(0, remaining);
+        }
+    }
+
+private:
+    const Board* board_ = nullptr;
+    vector<int> hidden;
+    vector<int> numbers;        // Revealed tiles, zeros included
+    vector<bool> minedNow;
+
+    void place(size_t next, int remaining) {
+        if (remaining == 0) {
+            if (matches()) {
+                layouts++;
+                for (int index : hidden) {
+                    mined[index] += minedNow[index];
+                }
+            }
+            return;
+        }
+        for (size_t i = next; i + remaining <= hidden.size(); i++) {
+            minedNow[hidden[i]] = true;
+            place(i + 1, remaining - 1);
+            minedNow[hidden[i]] = false;
+        }
+    }
+
+    // Whether every revealed number sees as many mines as it shows, with flags as mines
+    bool matches() const {
+        const Board& board = *board_;
+        for (int index : numbers) {
+            int around = 0;
+            for (int offset : board.neighborOffsets) {
+                const Tile& tile = board.tiles[index + offset];
+                around += !tile.isBorder() && (tile.isFlagged() || minedNow[index + offset]);
+            }
+            if (around != board.tiles[index].adjacentMineCount()) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Flags or unflags a random tile, usually a mine, or reveals it if it is safe. Returns true if anything changed.
+bool playMove(Game& game, Rng& moves) {
+    int row = (int)moves.below((uint64_t)game.rows());
+    int col = (int)moves.below((uint64_t)game.cols());
+    const Tile& tile = game.board.tileAt(row, col);
+    if (tile.isRevealed()) {
+        return false;
+    }
+    // Wrong flags are rare and soon lifted, so most positions still have a matching layout
+    if (tile.isFlagged() && !tile.isMined()) {
+        return moves.below(2) == 0 && game.toggleFlag(row, col);
+    }
+    if (moves.below(4) == 0 && (tile.isMined() || moves.below(8) == 0)) {
+        return game.toggleFlag(row, col);
+    }
+    return !tile.isMined() && !game.reveal(row, col).empty();
+}
+
+int main(int argc, char* argv[]) {
+    int games = argc > 1 ? stoi(argv[1]) : 1000;
+    uint64_t seed = argc > 2 ? stoull(argv[2]) : 1;
+    int threads = argc > 3 ? stoi(argv[3]) : 2;
+
+    ProbabilityEngine engine(threads);
+    BruteForce brute;
+    int failures = 0;
+    long long positions = 0;
+    long long unmatched = 0;    // Positions no placement matches, after a wrong flag
+    for (int g = 0; g < games; g++) {
+        int rows = 3 + (int)(Rng::stream(seed, (uint64_t)g) % 3);
+        int cols = 3 + (int)(Rng::stream(seed + 1, (uint64_t)g) % 4);
+        int mines = 1 + (int)(Rng::stream(seed + 2, (uint64_t)g) % (uint64_t)(rows * cols / 4));
+        Game game(rows, cols, mines, Rng::stream(seed + 3, (uint64_t)g));
+        game.trackChanges = false;
+        Rng moves(Rng::stream(seed + 4, (uint64_t)g));
+        game.reveal((int)moves.below((uint64_t)rows), (int)moves.below((uint64_t)cols));
+
+        bool changed = true;
+        while (!game.isOver()) {
+            const Board& board = game.board;
+            if (!changed) {
+                changed = playMove(game, moves);
+                continue;
+            }
+            brute.count(board);
+            bool computed = engine.compute(board);
+            positions++;
+            unmatched += brute.layouts == 0;
+            if (computed != (brute.layouts > 0)) {
+                cout << "FAILED: game " << g << " position " << positions << ": the engine "
+                     << (computed ? "found" : "did not find") << " a layout, brute force found " << brute.layouts
+                     << endl;
+                failures++;
+            }
+            else if (computed) {
+                for (int row = 0; row < rows; row++) {
+                    for (int col = 0; col < cols; col++) {
+                        int index = board.index(row, col);
+                        const Tile& tile = board.tiles[index];
+                        double expected = tile.isFlagged() ? 1.0 : brute.mined[index] / brute.layouts;
+                        if (fabs(engine.probability[index] - expected) > TOLERANCE) {
+                            cout << "FAILED: game " << g << " tile " << row << "," << col << ": engine "
+                                 << engine.probability[index] << ", brute force " << expected << endl;
+                            failures++;
+                        }
+                    }
+                }
+            }
+
+            changed = playMove(game, moves);
+        }
+    }
+
+    cout << games << " games, " << positions << " positions, " << unmatched << " with no matching layout" << endl;
+    cout << (failures == 0 ? "All probability checks passed." : to_string(failures) + " probability checks failed.")
+         << endl;
+    return failures == 0 ? 0 : 1;
+}
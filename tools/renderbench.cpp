@@ -0,0 +1,137 @@
+// Compares the frame rate of the batched board renderer against the old per-sprite drawing,
+// both when every tile is redrawn and when the cached board is reused.
+// Renders offscreen, so it runs without opening a window.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/renderbench.cpp -o renderbench -lsfml-graphics -lsfml-window -lsfml-system
+// Usage: renderbench [rows] [cols] [frames]
+#include "boardrenderer.h"
+#include "textures.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// The board drawing as it was done before the batched renderer: one sprite per layer per tile,
+// with up to four draw calls per tile every frame.
+class SpriteBoard {
+public:
+    vector<vector<sf::Sprite>> baseSprites2D;
+    vector<vector<sf::Sprite>> flagSprites2D;
+    vector<vector<sf::Sprite>> mineSprites2D;
+    vector<vector<sf::Sprite>> numberSprites2D;
+
+    SpriteBoard(const Game& game, const Textures& textures) {
+        for (int i = 0; i < game.rows(); i++) {
+            vector<sf::Sprite> spriteRow, flagRow, mineRow, numRow;
+            for (int j = 0; j < game.cols(); j++) {
+                const Tile& tile = game.tileAt(i, j);
+                sf::Sprite sprite, flagSprite, mineSprite, numSprite;
+                textures.apply(sprite, tile.isRevealed() ? TEXTURE_TILE_REVEALED : TEXTURE_TILE_HIDDEN);
+                textures.apply(flagSprite, TEXTURE_FLAG);
+                textures.apply(mineSprite, TEXTURE_MINE);
+                if (tile.adjacentMineCount() > 0) {
+                    textures.apply(numSprite, (TextureId)(TEXTURE_NUMBER_1 + tile.adjacentMineCount() - 1));
+                }
+                for (sf::Sprite* s : {&sprite, &flagSprite, &mineSprite, &numSprite}) {
+                    s->setPosition((float)(32 * j), (float)(32 * i));
+                }
+                spriteRow.push_back(sprite);
+                flagRow.push_back(flagSprite);
+                mineRow.push_back(mineSprite);
+                numRow.push_back(numSprite);
+            }
+            baseSprites2D.push_back(spriteRow);
+            flagSprites2D.push_back(flagRow);
+            mineSprites2D.push_back(mineRow);
+            numberSprites2D.push_back(numRow);
+        }
+    }
+
+    void draw(sf::RenderTarget& target, const Game& game, bool debugMode) {
+        for (int row = 0; row < game.rows(); row++) {
+            for (int col = 0; col < game.cols(); col++) {
+                const Tile& tile = game.tileAt(row, col);
+                target.draw(baseSprites2D[row][col]);
+                if (tile.isFlagged()) {
+                    target.draw(flagSprites2D[row][col]);
+                }
+                if (tile.isRevealed() && !tile.isMined() && tile.adjacentMineCount() > 0) {
+                    numberSprites2D[row][col].setPosition((float)(32 * col), (float)(32 * row));
+                    target.draw(numberSprites2D[row][col]);
+                }
+                if (debugMode && tile.isMined()) {
+                    mineSprites2D[row][col].setPosition((float)(32 * col), (float)(32 * row));
+                    target.draw(mineSprites2D[row][col]);
+                }
+            }
+        }
+    }
+};
+
+// Renders frames until the count is reached and returns the frames per second.
+template <typename DrawFrame>
+double measureFps(sf::RenderTexture& target, int frames, DrawFrame drawFrame) {
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        target.clear(sf::Color::White);
+        drawFrame();
+        target.display();
+    }
+    // Wait for the GPU so queued frames are counted
+    target.getTexture().copyToImage();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return frames / seconds;
+}
+
+int main(int argc, char* argv[]) {
+    int rows = argc > 1 ? stoi(argv[1]) : 100;
+    int cols = argc > 2 ? stoi(argv[2]) : 100;
+    int frames = argc > 3 ? stoi(argv[3]) : 200;
+
+    Textures textures;
+
+    // A game in progress: part of the board revealed, some flags placed, mines shown in debug mode
+    Game game(rows, cols, rows * cols / 6);
+    mt19937 mt(1);
+    for (int i = 0; i < rows * cols / 50 && !game.isOver(); i++) {
+        int row = (int)(mt() % rows);
+        int col = (int)(mt() % cols);
+        if (game.tileAt(row, col).isMined()) {
+            game.toggleFlag(row, col);
+        }
+        else {
+            game.reveal(row, col);
+        }
+    }
+
+    sf::RenderTexture target;
+    if (!target.create(cols * 32, rows * 32)) {
+        cout << "Could not create a " << cols * 32 << "x" << rows * 32 << " render texture." << endl;
+        return 1;
+    }
+
+    SpriteBoard spriteBoard(game, textures);
+    double spriteFps = measureFps(target, frames, [&]() { spriteBoard.draw(target, game, true); });
+
+    BoardRenderer renderer;
+    renderer.useAtlas(textures);
+    double batchedFps = measureFps(target, frames, [&]() {
+        renderer.invalidate();
+        renderer.update(game, true, false);
+        renderer.draw(target);
+    });
+    double cachedFps = measureFps(target, frames, [&]() {
+        renderer.update(game, true, false);
+        renderer.draw(target);
+    });
+
+    cout << "Board " << rows << "x" << cols << ", " << frames << " frames" << endl;
+    cout << "  per-sprite draws: " << spriteFps << " fps" << endl;
+    cout << "  batched renderer: " << batchedFps << " fps (" << batchedFps / spriteFps << "x)" << endl;
+    cout << "  cached, no changes: " << cachedFps << " fps (" << cachedFps / spriteFps << "x)" << endl;
+    return 0;
+}
@@ -0,0 +1,190 @@
+// Checks the replay format (replay.h) against recorded games and malformed or tampered input.
+// Random games are recorded and must play back to the state they recorded, and won no-guess games must play
+// back to a win. Every truncation of them must be
+// rejected, and every single-byte change must either be rejected or still play back to its recorded end.
+// Headers with sizes that overflow, oversized boards, too many mines, overlong varints, tiles off the board and
+// unknown events must all be rejected. Exits with 1 if any check fails.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/replaycheck.cpp -o replaycheck
+// Usage: replaycheck [games] [seed]
+#include "replay.h"
+#include "solver.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int failures = 0;
+
+void check(bool passed, const string& what) {
+    if (!passed) {
+        cout << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+// Plays random moves until the game ends, recording them
+vector<uint8_t> recordGame(int rows, int cols, int mines, uint64_t seed) {
+    Game game(rows, cols, mines, seed);
+    game.trackChanges = false;
+    ReplayWriter writer;
+    writer.begin(game);
+    Rng moves(seed);
+    uint64_t time = 0;
+    for (int move = 0; move < 4 * rows * cols && !game.isOver(); move++) {
+        int row = (int)moves.below((uint64_t)rows);
+        int col = (int)moves.below((uint64_t)cols);
+        time += moves.below(2000);
+        int kind = (int)moves.below(10);
+        if (kind == 0) {
+            game.toggleFlag(row, col);
+            writer.tileEvent(REPLAY_FLAG, row, col, time);
+        }
+        else if (kind == 1) {
+            game.chord(row, col);
+            writer.tileEvent(REPLAY_CHORD, row, col, time);
+        }
+        else {
+            game.reveal(row, col);
+            writer.tileEvent(REPLAY_REVEAL, row, col, time);
+        }
+    }
+    writer.end(game, time);
+    return writer.data;
+}
+
+// Plays a no-guess game from the middle revealing only tiles the solver deduces safe, which wins it, recording
+// the moves
+vector<uint8_t> recordNoGuessGame(int rows, int cols, int mines, uint64_t seed) {
+    Game game(rows, cols, mines, seed);
+    game.trackChanges = false;
+    game.noGuess = true;
+    ReplayWriter writer;
+    writer.begin(game);
+    Solver solver;
+    solver.reset(game.board);
+    uint64_t time = 0;
+    int next = game.board.index(rows / 2, cols / 2);
+    size_t safeTaken = 0;
+    while (next >= 0 && !game.isOver()) {
+        time += 100;
+        solver.notifyRevealed(game.reveal(game.board.rowOf(next), game.board.colOf(next)));
+        writer.tileEvent(REPLAY_REVEAL, game.board.rowOf(next), game.board.colOf(next), time);
+        solver.solve();
+        next = -1;
+        while (safeTaken < solver.safeTiles.size() && next < 0) {
+            int index = solver.safeTiles[safeTaken++];
+            if (!game.board.tiles[index].isRevealed()) {
+                next = index;
+            }
+        }
+    }
+    writer.end(game, time);
+    return game.gameWon ? writer.data : vector<uint8_t>();
+}
+
+// A replay header with the given fields, optionally followed by an END event claiming an unplayed game
+vector<uint8_t> header(uint64_t rows, uint64_t cols, uint64_t mines, bool withEnd = true) {
+    vector<uint8_t> data = {'M', 'S', 'R', 'P'};
+    writeVarint(data, REPLAY_VERSION);
+    writeVarint(data, rows);
+    writeVarint(data, cols);
+    writeVarint(data, mines);
+    writeVarint(data, 0);
+    data.insert(data.end(), 8, 0);
+    if (withEnd) {
+        writeVarint(data, REPLAY_END);
+        writeVarint(data, 0);
+        writeVarint(data, 0);
+    }
+    return data;
+}
+
+bool plays(ReplayPlayer& player, const vector<uint8_t>& data) {
+    ReplayResult result;
+    return player.play(data.data(), data.size(), result);
+}
+
+int main(int argc, char* argv[]) {
+    int games = argc > 1 ? stoi(argv[1]) : 200;
+    uint64_t seed = argc > 2 ? stoull(argv[2]) : 1;
+    ReplayPlayer player;
+
+    // Recorded games play back, and no truncation or byte change of them is accepted with another outcome
+    long long truncations = 0;
+    long long changes = 0;
+    long long changesAccepted = 0;
+    for (int i = 0; i < games; i++) {
+        int rows = 2 + (int)(Rng::stream(seed, (uint64_t)i) % 12);
+        int cols = 2 + (int)(Rng::stream(seed + 1, (uint64_t)i) % 20);
+        int mines = 1 + (int)(Rng::stream(seed + 2, (uint64_t)i) % (uint64_t)(rows * cols / 3 + 1));
+        vector<uint8_t> replay = recordGame(rows, cols, mines, Rng::stream(seed + 3, (uint64_t)i));
+        check(plays(player, replay), "game " + to_string(i) + " does not play back");
+
+        for (size_t length = 0; length < replay.size(); length++) {
+            vector<uint8_t> truncated(replay.begin(), replay.begin() + (ptrdiff_t)length);
+            check(!plays(player, truncated), "game " + to_string(i) + " truncated to " + to_string(length) + " bytes");
+            truncations++;
+        }
+
+        Rng flips(Rng::stream(seed + 4, (uint64_t)i));
+        for (size_t position = 0; position < replay.size(); position++) {
+            vector<uint8_t> changed = replay;
+            changed[position] ^= (uint8_t)(1 + flips.below(255));
+            // Playing it must not crash; if it is accepted, the player re-executed it to its recorded end
+            changesAccepted += plays(player, changed);
+            changes++;
+        }
+    }
+
+    // No-guess games place their mines differently, so playing one back must place the same no-guess board
+    int noGuessWins = 0;
+    for (int i = 0; i < games / 4; i++) {
+        vector<uint8_t> replay = recordNoGuessGame(9, 9, 10, Rng::stream(seed + 5, (uint64_t)i));
+        check(!replay.empty(), "no-guess game " + to_string(i) + " was not won by deduction");
+        ReplayResult result;
+        check(replay.empty() || (player.play(replay.data(), replay.size(), result) && result.won),
+              "no-guess game " + to_string(i) + " does not play back to a win");
+        noGuessWins++;
+    }
+
+    // Malformed headers and events
+    check(plays(player, header(3, 3, 1)), "a minimal well-formed replay is rejected");
+    check(!plays(player, header((uint64_t)1 << 33, (uint64_t)1 << 31, 0)), "rows * cols wrapping to 0");
+    check(!plays(player, header((uint64_t)1 << 32, (uint64_t)1 << 32, 0)), "rows * cols wrapping to 0 (2^32 x 2^32)");
+    check(!plays(player, header(REPLAY_MAX_TILES, 2, 1)), "a board over REPLAY_MAX_TILES");
+    check(!plays(player, header((uint64_t)REPLAY_MAX_TILES + 1, 1, 1)), "rows over REPLAY_MAX_TILES");
+    check(!plays(player, header(0, 5, 0)), "zero rows");
+    check(!plays(player, header(3, 3, 10)), "more mines than tiles");
+
+    vector<uint8_t> overlong = header(3, 3, 1, false);
+    overlong.insert(overlong.end(), 11, 0xFF);
+    check(!plays(player, overlong), "an overlong varint");
+
+    vector<uint8_t> offBoard = header(3, 3, 1, false);
+    writeVarint(offBoard, REPLAY_REVEAL);
+    writeVarint(offBoard, 9);
+    check(!plays(player, offBoard), "a tile off the board");
+
+    vector<uint8_t> unknownEvent = header(3, 3, 1, false);
+    writeVarint(unknownEvent, 6);
+    writeVarint(unknownEvent, 0);
+    check(!plays(player, unknownEvent), "an unknown event type");
+
+    vector<uint8_t> trailing = header(3, 3, 1);
+    trailing.push_back(0);
+    check(!plays(player, trailing), "bytes after the END event");
+
+    vector<uint8_t> wrongEnd = header(3, 3, 1, false);
+    writeVarint(wrongEnd, REPLAY_END);
+    writeVarint(wrongEnd, 1);
+    writeVarint(wrongEnd, 0);
+    check(!plays(player, wrongEnd), "an END event claiming a win that was not played");
+
+    cout << games << " games, " << noGuessWins << " no-guess wins, " << truncations << " truncations rejected, " << changes << " byte changes ("
+         << changesAccepted << " still valid replays)" << endl;
+    cout << (failures == 0 ? "All replay checks passed." : to_string(failures) + " replay checks failed.") << endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+// Checks that starting a new game reuses the storage of the last one. Game::reset and the first reveal of the
+// next game are run on boards from beginner to 1000x1000, for ordinary, safe-neighborhood and no-guess games,
+// counting heap allocations; after a few warm-up games none may allocate. Exits with 1 if any does.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/resetcheck.cpp -o resetcheck
+// Usage: resetcheck [games] [seed]
+#include "game.h"
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+using namespace std;
+
+// Heap allocations made so far
+long long allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    void* memory = malloc(size ? size : 1);
+    if (!memory) {
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+const int WARM_UP_GAMES = 3;
+
+struct BoardSize {
+    string name;
+    int rows;
+    int cols;
+    int mines;
+};
+
+int main(int argc, char* argv[]) {
+    int games = argc > 1 ? stoi(argv[1]) : 20;
+    uint64_t seed = argc > 2 ? stoull(argv[2]) : 1;
+    const BoardSize sizes[] = {
+        {"beginner", 9, 9, 10},
+        {"expert", 16, 30, 99},
+        {"100x100", 100, 100, 2062},
+        {"1000x1000", 1000, 1000, 206250},
+    };
+    const string modes[] = {"ordinary", "safe neighborhood", "no-guess"};
+
+    int failures = 0;
+    for (const BoardSize& size : sizes) {
+        for (int mode = 0; mode < 3; mode++) {
+            // No-guess generation on the largest board takes too long to repeat
+            if (mode == 2 && size.rows * size.cols > 100 * 100) {
+                continue;
+            }
+            Game game(size.rows, size.cols, size.mines, seed);
+            game.safeNeighborhood = mode == 1;
+            game.noGuess = mode == 2;
+            long long allocated = 0;
+            for (int i = 0; i < WARM_UP_GAMES + games; i++) {
+                long long before = allocations;
+                game.reset(Rng::stream(seed, (uint64_t)i));
+                game.reveal(size.rows / 2, size.cols / 2);
+                if (i >= WARM_UP_GAMES) {
+                    allocated += allocations - before;
+                }
+            }
+            if (allocated > 0) {
+                cout << "FAILED: " << modes[mode] << " " << size.name << " games allocate " << allocated
+                     << " times in " << games << " resets" << endl;
+                failures++;
+            }
+        }
+    }
+    cout << (failures == 0 ? "No reset allocates." : to_string(failures) + " reset checks failed.") << endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,258 @@
+// Checks the score log (scorestore.h) against torn and corrupted writes and against compaction.
+// Results are written through a ScoreStore, then the log is cut at every byte of its last records, and single
+// bytes of each record are changed. Reopening must load exactly the records before the damage, in order, keep
+// the same leaderboards as those records alone, and cut the log back to them. A store given enough results
+// to compact must keep the same leaderboards across the compaction and a reopen, also when results are added
+// while it compacts, and must not write any result twice.
+// Exits with 1 if any check fails.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/scorestorecheck.cpp -o scorestorecheck -pthread
+// Usage: scorestorecheck [directory] [seed]
+// The directory is created if needed and the files it writes there are removed afterwards.
+#include "rng.h"
+#include "scorestore.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+typedef tuple<int, int, int> Config;
+
+const Config CONFIGS[] = {Config(9, 9, 10), Config(16, 16, 40), Config(16, 30, 99)};
+
+int failures = 0;
+
+void check(bool passed, const string& what) {
+    if (!passed) {
+        cout << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+bool same(const Score& a, const Score& b) {
+    return a.rows == b.rows && a.cols == b.cols && a.mines == b.mines && a.seconds == b.seconds && a.name == b.name
+           && a.replay == b.replay;
+}
+
+bool same(const vector<Score>& a, const vector<Score>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!same(a[i], b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Score randomScore(Rng& rng) {
+    Score score;
+    tie(score.rows, score.cols, score.mines) = CONFIGS[rng.below(3)];
+    score.seconds = (uint32_t)rng.below(200);
+    for (uint64_t length = rng.below(20); length > 0; length--) {
+        score.name.push_back((char)('a' + rng.below(26)));
+    }
+    if (rng.below(2) == 0) {
+        for (uint64_t length = 1 + rng.below(64); length > 0; length--) {
+            score.replay.push_back((uint8_t)rng.below(256));
+        }
+    }
+    return score;
+}
+
+// The leaderboard of a board from its results in the order they were added: fastest first, newer results
+// before older ones with the same time, at most TOP_COUNT
+vector<Score> expectedTop(const vector<Score>& added, const Config& config) {
+    vector<Score> results;
+    for (auto score = added.rbegin(); score != added.rend(); ++score) {
+        if (Config(score->rows, score->cols, score->mines) == config) {
+            results.push_back(*score);
+        }
+    }
+    stable_sort(results.begin(), results.end(),
+                [](const Score& a, const Score& b) { return a.seconds < b.seconds; });
+    if (results.size() > (size_t)ScoreStore::TOP_COUNT) {
+        results.resize(ScoreStore::TOP_COUNT);
+    }
+    return results;
+}
+
+vector<uint8_t> readFile(const string& path) {
+    ifstream infile(path, ios::binary);
+    return vector<uint8_t>((istreambuf_iterator<char>(infile)), istreambuf_iterator<char>());
+}
+
+void writeFile(const string& path, const vector<uint8_t>& data, size_t size) {
+    ofstream outfile(path, ios::binary | ios::trunc);
+    outfile.write((const char*)data.data(), (streamsize)size);
+}
+
+// Opens the log, which must hold exactly the first records of added, and checks what the store loaded
+void checkReopened(const string& logPath, const string& leaderboardPath, const vector<Score>& added, size_t records,
+                   size_t intactSize, const string& what) {
+    {
+        // The store reports each torn tail it drops; silenced here, since every reopen drops one
+        cout.setstate(ios::failbit);
+        ScoreStore store(logPath, leaderboardPath, 9, 9, 10);
+        cout.clear();
+        vector<Score> intact(added.begin(), added.begin() + (ptrdiff_t)records);
+        for (const Config& config : CONFIGS) {
+            check(same(store.top(get<0>(config), get<1>(config), get<2>(config)), expectedTop(intact, config)),
+                  what + ": leaderboard differs from the intact records");
+        }
+    }
+    vector<uint8_t> data = readFile(logPath);
+    vector<Score> loaded;
+    check(data.size() == intactSize, what + ": log is " + to_string(data.size()) + " bytes, not cut back to "
+                                         + to_string(intactSize));
+    check(ScoreStore::parseLog(data, loaded) == intactSize, what + ": log has a damaged tail after reopening");
+    check(same(loaded, vector<Score>(added.begin(), added.begin() + (ptrdiff_t)records)),
+          what + ": log does not hold exactly the intact records");
+}
+
+int main(int argc, char* argv[]) {
+    filesystem::path directory = argc > 1 ? filesystem::path(argv[1])
+                                          : filesystem::temp_directory_path() / "scorestorecheck";
+    uint64_t seed = argc > 2 ? stoull(argv[2]) : 1;
+    filesystem::create_directories(directory);
+    string logPath = (directory / "scores.log").string();
+    string leaderboardPath = (directory / "leaderboard.txt").string();
+    Rng rng(seed);
+
+    // Fewer results than it takes to compact, so the log holds every one in order
+    vector<Score> added;
+    filesystem::remove(logPath);
+    filesystem::remove(leaderboardPath);
+    {
+        ScoreStore store(logPath, leaderboardPath, 9, 9, 10);
+        for (int i = 0; i < 40; i++) {
+            added.push_back(randomScore(rng));
+            store.add(added.back());
+        }
+    }
+    vector<uint8_t> original = readFile(logPath);
+    vector<Score> loaded;
+    check(ScoreStore::parseLog(original, loaded) == original.size() && same(loaded, added),
+          "written log does not hold every result in order");
+
+    // Where each record starts, and the end of the last
+    vector<size_t> bounds;
+    for (size_t offset = 8; offset <= original.size();) {
+        bounds.push_back(offset);
+        if (offset + 4 > original.size()) {
+            break;
+        }
+        offset += 8 + (original[offset] | (size_t)original[offset + 1] << 8 | (size_t)original[offset + 2] << 16
+                       | (size_t)original[offset + 3] << 24);
+    }
+    check(bounds.size() == added.size() + 1 && bounds.back() == original.size(), "record bounds do not add up");
+
+    // Torn writes: the log cut at every byte of its last three records, and inside some earlier ones
+    int truncations = 0;
+    for (size_t size = bounds[bounds.size() - 4]; size < original.size(); size++) {
+        size_t records = (size_t)(upper_bound(bounds.begin(), bounds.end(), size) - bounds.begin()) - 1;
+        writeFile(logPath, original, size);
+        checkReopened(logPath, leaderboardPath, added, records, bounds[records], "cut at " + to_string(size));
+        truncations++;
+    }
+    for (size_t record = 0; record + 4 < added.size(); record += 5) {
+        size_t size = bounds[record] + 1 + rng.below(bounds[record + 1] - bounds[record] - 1);
+        writeFile(logPath, original, size);
+        checkReopened(logPath, leaderboardPath, added, record, bounds[record], "cut at " + to_string(size));
+        truncations++;
+    }
+
+    // Corruption: one changed byte in a record keeps every record before it
+    int corruptions = 0;
+    for (size_t record = 0; record < added.size(); record++) {
+        vector<uint8_t> changed = original;
+        changed[bounds[record] + rng.below(bounds[record + 1] - bounds[record])] ^= (uint8_t)(1 + rng.below(255));
+        writeFile(logPath, changed, changed.size());
+        checkReopened(logPath, leaderboardPath, added, record, bounds[record],
+                      "byte changed in record " + to_string(record));
+        corruptions++;
+    }
+
+    // Compaction: enough results for the log to be rewritten with only the kept ones, more than once
+    added.clear();
+    filesystem::remove(logPath);
+    filesystem::remove(leaderboardPath);
+    {
+        ScoreStore store(logPath, leaderboardPath, 9, 9, 10);
+        for (int i = 0; i < 500; i++) {
+            added.push_back(randomScore(rng));
+            store.add(added.back());
+            if (i % 50 == 49) {
+                store.flush();
+            }
+        }
+        store.flush();
+        for (const Config& config : CONFIGS) {
+            check(same(store.top(get<0>(config), get<1>(config), get<2>(config)), expectedTop(added, config)),
+                  "leaderboard differs from the added results before reopening");
+        }
+    }
+    vector<uint8_t> compacted = readFile(logPath);
+    loaded.clear();
+    check(ScoreStore::parseLog(compacted, loaded) == compacted.size(), "compacted log has a damaged tail");
+    check(loaded.size() < added.size(), "log was not compacted: " + to_string(loaded.size()) + " records");
+    {
+        ScoreStore store(logPath, leaderboardPath, 9, 9, 10);
+        for (const Config& config : CONFIGS) {
+            check(same(store.top(get<0>(config), get<1>(config), get<2>(config)), expectedTop(added, config)),
+                  "leaderboard differs from the added results after compacting and reopening");
+        }
+    }
+
+    // Compaction while results keep being added, each the fastest yet so it is kept: results added while the
+    // writer works must be written once, not in a compacted log and then again after it
+    vector<Score> racing;
+    filesystem::remove(logPath);
+    filesystem::remove(leaderboardPath);
+    {
+        ScoreStore store(logPath, leaderboardPath, 9, 9, 10);
+        for (int i = 0; i < 3000; i++) {
+            Score score = randomScore(rng);
+            score.seconds = (uint32_t)(100000 - i);
+            score.name = "racer" + to_string(i);
+            racing.push_back(score);
+            store.add(score);
+            // Varied pauses land adds at every point of the writer's work
+            this_thread::sleep_for(chrono::microseconds(rng.below(100)));
+        }
+    }
+    vector<uint8_t> raced = readFile(logPath);
+    vector<Score> racedRecords;
+    check(ScoreStore::parseLog(raced, racedRecords) == raced.size(), "log compacted while adding has a damaged tail");
+    int duplicates = 0;
+    for (size_t i = 0; i < racedRecords.size(); i++) {
+        for (size_t j = i + 1; j < racedRecords.size(); j++) {
+            duplicates += same(racedRecords[i], racedRecords[j]);
+        }
+    }
+    check(duplicates == 0, "log compacted while adding holds " + to_string(duplicates) + " duplicate records");
+    {
+        ScoreStore store(logPath, leaderboardPath, 9, 9, 10);
+        for (const Config& config : CONFIGS) {
+            check(same(store.top(get<0>(config), get<1>(config), get<2>(config)), expectedTop(racing, config)),
+                  "leaderboard differs from the added results after compacting while adding");
+        }
+    }
+
+    filesystem::remove(logPath);
+    filesystem::remove(leaderboardPath);
+    cout << truncations << " truncations, " << corruptions << " corrupted records, " << added.size()
+         << " results compacted to " << loaded.size() << " records" << endl;
+    cout << (failures == 0 ? "All score store checks passed." : to_string(failures) + " score store checks failed.")
+         << endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+// Plays many seeded games with a bot strategy (selfplay.h) on every core and reports the win rate with its
+// 95% Wilson confidence interval, the clicks per game and the games per second.
+// With threads 0 it plays the same games on 1, 2, 4, ... threads up to the number of cores instead, and
+// reports the speedup of each over one thread. The results must match on every thread count, since each
+// game depends only on its seed.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/selfplay.cpp -o selfplay -pthread
+// Usage: selfplay [random|solver|probability] [games] [threads] [rows] [cols] [mines] [seed]
+#include "selfplay.h"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+void printResult(const SelfPlayResult& result, int threads) {
+    double low, high;
+    wilsonInterval(result.wins, result.games, low, high);
+    cout << "  win rate:     " << 100.0 * result.winRate() << "% (95% CI " << 100.0 * low << "% - " << 100.0 * high
+         << "%), " << result.wins << " of " << result.games << endl;
+    cout << "  clicks/game:  " << result.clicksPerGame() << endl;
+    cout << "  throughput:   " << result.gamesPerSecond() << " games/s on " << threads << " threads, "
+         << result.gamesPerSecond() / threads << " games/s per thread" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    string name = argc > 1 ? argv[1] : "solver";
+    long long games = argc > 2 ? stoll(argv[2]) : 100000;
+    int threads = argc > 3 ? stoi(argv[3]) : (int)thread::hardware_concurrency();
+    int rows = argc > 4 ? stoi(argv[4]) : 16;
+    int cols = argc > 5 ? stoi(argv[5]) : 30;
+    int mines = argc > 6 ? stoi(argv[6]) : 99;
+    uint64_t seed = argc > 7 ? stoull(argv[7]) : 1;
+
+    if (!makeStrategy(name)) {
+        cout << "Unknown strategy " << name << ". Strategies: random, solver, probability." << endl;
+        return 1;
+    }
+    if (rows < 1 || cols < 1 || mines < 0 || mines >= rows * cols || games < 1 || threads < 0) {
+        cout << "Invalid board size, mine count, games or threads." << endl;
+        return 1;
+    }
+
+    SelfPlay selfPlay(rows, cols, mines, seed);
+    auto newStrategy = [&name]() { return makeStrategy(name); };
+    cout << name << " on " << rows << "x" << cols << ", " << mines << " mines, " << games << " games, seed " << seed
+         << endl;
+
+    if (threads > 0) {
+        printResult(selfPlay.run(newStrategy, games, threads), threads);
+        return 0;
+    }
+
+    // Scaling: the same games on more and more threads
+    int cores = max((int)thread::hardware_concurrency(), 1);
+    SelfPlayResult single;
+    bool consistent = true;
+    for (int count = 1; ; count = min(count * 2, cores)) {
+        SelfPlayResult result = selfPlay.run(newStrategy, games, count);
+        if (count == 1) {
+            single = result;
+            printResult(result, 1);
+        }
+        consistent = consistent && result.wins == single.wins && result.clicks == single.clicks;
+        double speedup = result.gamesPerSecond() / single.gamesPerSecond();
+        cout << "  " << count << " threads: " << result.gamesPerSecond() << " games/s, speedup " << speedup
+             << ", efficiency " << 100.0 * speedup / count << "%" << endl;
+        if (count == cores) {
+            break;
+        }
+    }
+    if (!consistent) {
+        cout << "  RESULTS DIFFER BETWEEN THREAD COUNTS" << endl;
+        return 1;
+    }
+    return 0;
+}
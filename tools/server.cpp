@@ -0,0 +1,41 @@
+// Hosts game sessions for clients over a local socket (server.h) until interrupted, then prints the
+// number of requests served and the time each took to handle.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/server.cpp -o server -pthread
+// Usage: server [address] [workers] [max sessions]
+// The address is "unix:/path/to/socket", "port" or "host:port" on the loopback interface (default 7878).
+#include "server.h"
+#include <csignal>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+volatile sig_atomic_t interrupted = 0;
+
+void onInterrupt(int) {
+    interrupted = 1;
+}
+
+int main(int argc, char* argv[]) {
+    string address = argc > 1 ? argv[1] : "7878";
+    int workers = argc > 2 ? stoi(argv[2]) : (int)thread::hardware_concurrency();
+    int maxSessions = argc > 3 ? stoi(argv[3]) : 100000;
+
+    signal(SIGINT, onInterrupt);
+    signal(SIGTERM, onInterrupt);
+    signal(SIGPIPE, SIG_IGN);
+
+    GameServer server(workers, maxSessions);
+    if (!server.start(address)) {
+        cout << "Error: cannot listen on " << address << "." << endl;
+        return 1;
+    }
+    cout << "Serving on " << address << " with " << workers << " workers." << endl;
+    server.run([]() { return interrupted != 0; });
+
+    cout << server.requestCount << " requests, " << server.sessionCount << " sessions open." << endl;
+    cout << "Request handling times:" << endl << tracer().summary();
+    return 0;
+}
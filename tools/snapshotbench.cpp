@@ -0,0 +1,126 @@
+// Measures snapshots of a game (snapshot.h) for undo and for trying hypothetical moves.
+// An oracle that knows the mines plays a large board with random safe reveals and correct flags, taking a
+// snapshot after every move, and reports the memory each snapshot adds against the tiles the move changed.
+// It then undoes every move, checking the board against full copies taken along the way, and finally
+// branches a reveal of each hidden safe tile from one position, comparing restoring a snapshot with
+// copying the whole game.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/snapshotbench.cpp -o snapshotbench
+// Usage: snapshotbench [rows] [cols] [mines] [seed]
+#include "game.h"
+#include "snapshot.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const int CHECK_EVERY = 16;         // Moves between full copies of the board to check undo against
+const int MAX_BRANCHES = 5000;
+
+bool sameTiles(const vector<Tile>& a, const vector<Tile>& b) {
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(Tile)) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    int rows = argc > 1 ? stoi(argv[1]) : 1000;
+    int cols = argc > 2 ? stoi(argv[2]) : 1000;
+    int mines = argc > 3 ? stoi(argv[3]) : 150000;
+    uint64_t seed = argc > 4 ? stoull(argv[4]) : 1;
+
+    Game game(rows, cols, mines, seed);
+    game.trackChanges = false;
+    GameSnapshots snapshots(game);
+    game.reveal(rows / 2, cols / 2);
+
+    vector<GameSnapshot> history;
+    vector<vector<Tile>> checkCopies;
+    history.push_back(snapshots.take());
+    checkCopies.push_back(game.board.tiles);
+
+    // Play until half of the safe tiles are revealed, flagging a mine now and then
+    Rng moves(seed);
+    long long changedTiles = 0;
+    size_t snapshotBytes = 0;
+    double takeSeconds = 0;
+    int safeTiles = rows * cols - game.mines();
+    while (!game.isOver() && game.board.nonMinesRevealed < safeTiles / 2) {
+        int row = (int)moves.below((uint64_t)rows);
+        int col = (int)moves.below((uint64_t)cols);
+        const Tile& tile = game.tileAt(row, col);
+        if (tile.isRevealed() || tile.isFlagged()) {
+            continue;
+        }
+        if (tile.isMined()) {
+            game.toggleFlag(row, col);
+            changedTiles++;
+        }
+        else {
+            changedTiles += (long long)game.reveal(row, col).size();
+        }
+
+        auto start = chrono::steady_clock::now();
+        history.push_back(snapshots.take(history.size()));
+        takeSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        snapshotBytes += history.back().bytesAdded;
+        if ((history.size() - 1) % CHECK_EVERY == 0) {
+            checkCopies.push_back(game.board.tiles);
+        }
+    }
+    size_t moveCount = history.size() - 1;
+    size_t boardBytes = game.board.tiles.size() * sizeof(Tile);
+    cout << moveCount << " moves on " << rows << "x" << cols << ", " << changedTiles << " tiles changed" << endl;
+    cout << "take: " << takeSeconds * 1e6 / moveCount << " us, " << snapshotBytes / moveCount << " bytes per snapshot, "
+         << (double)snapshotBytes / changedTiles << " bytes per changed tile (a full copy is " << boardBytes
+         << " bytes)" << endl;
+
+    // Undo every move
+    int wrong = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = history.size(); i-- > 0;) {
+        snapshots.restore(history[i]);
+        if (i % CHECK_EVERY == 0) {
+            wrong += !sameTiles(game.board.tiles, checkCopies[i / CHECK_EVERY]);
+        }
+    }
+    double undoSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    wrong += game.board.nonMinesRevealed != history[0].nonMinesRevealed || game.flagCounter != mines;
+    cout << "undo: " << undoSeconds * 1e6 / history.size() << " us per move, " << wrong << " wrong" << endl;
+
+    // Branch from the middle of the game: reveal each hidden safe tile, then go back
+    snapshots.restore(history[history.size() / 2]);
+    GameSnapshot base = snapshots.take();
+    vector<int> candidates;
+    for (int row = 0; row < rows && (int)candidates.size() < MAX_BRANCHES; row++) {
+        for (int col = 0; col < cols && (int)candidates.size() < MAX_BRANCHES; col++) {
+            const Tile& tile = game.tileAt(row, col);
+            if (!tile.isRevealed() && !tile.isMined() && !tile.isFlagged()) {
+                candidates.push_back(row * cols + col);
+            }
+        }
+    }
+
+    long long snapshotRevealed = 0;
+    start = chrono::steady_clock::now();
+    for (int position : candidates) {
+        snapshotRevealed += (long long)game.reveal(position / cols, position % cols).size();
+        snapshots.restore(base);
+    }
+    double snapshotSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    long long copyRevealed = 0;
+    start = chrono::steady_clock::now();
+    for (int position : candidates) {
+        Game branch = game;
+        copyRevealed += (long long)branch.reveal(position / cols, position % cols).size();
+    }
+    double copySeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    wrong += snapshotRevealed != copyRevealed;
+
+    cout << candidates.size() << " branches: " << snapshotSeconds * 1e6 / candidates.size() << " us with snapshots, "
+         << copySeconds * 1e6 / candidates.size() << " us copying the game" << endl;
+    return wrong == 0 ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+// Plays expert games with the constraint solver and measures the time it spends per move.
+// After every reveal the solver is told the revealed batch and runs to a fixed point; each deduced safe tile
+// is then revealed as the next move. When nothing is certain a random undecided tile is guessed.
+// Every deduction is checked against the real mine layout.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/solverbench.cpp -o solverbench
+// Usage: solverbench [games] [seed]
+#include "game.h"
+#include "solver.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    int games = argc > 1 ? stoi(argv[1]) : 10000;
+    uint64_t seed = argc > 2 ? stoull(argv[2]) : 1;
+
+    Game game(16, 30, 99, Rng::stream(seed, 0));
+    game.trackChanges = false;
+    Solver solver;
+    Rng guesses(seed);
+    vector<int> undecided;
+
+    long long moves = 0;
+    long long guessCount = 0;
+    long long wrongDeductions = 0;
+    int wins = 0;
+    double solverSeconds = 0;
+
+    for (int g = 0; g < games; g++) {
+        game.reset(Rng::stream(seed, g));
+        solver.reset(game.board);
+        size_t safeTaken = 0;
+        size_t minesChecked = 0;
+
+        int row = game.rows() / 2;
+        int col = game.cols() / 2;
+        while (!game.isOver()) {
+            const vector<int>& revealed = game.reveal(row, col);
+            moves++;
+
+            auto start = chrono::steady_clock::now();
+            solver.notifyRevealed(revealed);
+            solver.solve();
+            solverSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            for (; minesChecked < solver.mineTiles.size(); minesChecked++) {
+                wrongDeductions += !game.board.tiles[solver.mineTiles[minesChecked]].isMined();
+            }
+
+            // Next move: the next deduced safe tile that is still hidden, or a guess
+            int next = -1;
+            while (safeTaken < solver.safeTiles.size() && next < 0) {
+                int index = solver.safeTiles[safeTaken++];
+                wrongDeductions += game.board.tiles[index].isMined();
+                if (!game.board.tiles[index].isRevealed()) {
+                    next = index;
+                }
+            }
+            if (next < 0) {
+                undecided.clear();
+                for (int r = 0; r < game.rows(); r++) {
+                    for (int c = 0; c < game.cols(); c++) {
+                        int index = game.board.index(r, c);
+                        if (!game.board.tiles[index].isRevealed() && solver.known[index] == Solver::UNKNOWN) {
+                            undecided.push_back(index);
+                        }
+                    }
+                }
+                if (undecided.empty()) {
+                    break;
+                }
+                next = undecided[guesses.below(undecided.size())];
+                guessCount++;
+            }
+            row = game.board.rowOf(next);
+            col = game.board.colOf(next);
+        }
+        wins += game.gameWon;
+    }
+
+    cout << "Expert (16x30, 99 mines), " << games << " games" << (wrongDeductions ? "  WRONG DEDUCTIONS" : "") << endl;
+    cout << "  moves:            " << moves << " (" << guessCount << " guesses)" << endl;
+    cout << "  solver time:      " << solverSeconds * 1e6 / moves << " us/move" << endl;
+    cout << "  win rate:         " << 100.0 * wins / games << "%" << endl;
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Re-verifies leaderboard results by replaying their recorded games headlessly as fast as possible.
+// A result passes if its replay is well formed, reaches the recorded end state, wins on the result's board,
+// and its play time gives the claimed time. Files can be score logs (files/scores.log), whose results with
+// a replay are all checked, or single replay files.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. tools/verifyreplays.cpp -o verifyreplays -pthread
+// Usage: verifyreplays file...
+#include "replay.h"
+#include "scorestore.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Returns an empty string if the result is genuine, or why it is not
+string verify(ReplayPlayer& player, const Score& score) {
+    ReplayResult result;
+    if (!player.play(score.replay.data(), score.replay.size(), result)) {
+        return "replay is malformed or does not reach its recorded end";
+    }
+    if (!result.won) {
+        return "replay does not win";
+    }
+    if (result.rows != score.rows || result.cols != score.cols || result.mines != score.mines) {
+        return "replay is of a different board";
+    }
+    if (result.playMilliseconds / 1000 != score.seconds) {
+        return "claimed " + to_string(score.seconds) + " s, replay took " + to_string(result.playMilliseconds) + " ms";
+    }
+    return "";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cout << "Usage: verifyreplays file..." << endl;
+        return 1;
+    }
+
+    ReplayPlayer player;
+    long long verified = 0;
+    long long failed = 0;
+    double seconds = 0;
+
+    for (int i = 1; i < argc; i++) {
+        ifstream infile(argv[i], ios::binary);
+        if (!infile) {
+            cout << "Error: " << argv[i] << " cannot open in read mode." << endl;
+            failed++;
+            continue;
+        }
+        vector<uint8_t> data((istreambuf_iterator<char>(infile)), istreambuf_iterator<char>());
+
+        vector<Score> scores;
+        if (ScoreStore::parseLog(data, scores) == 0) {
+            // A single replay, with nothing claimed beyond its own end state
+            ReplayResult result;
+            auto start = chrono::steady_clock::now();
+            bool valid = player.play(data.data(), data.size(), result);
+            seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            cout << argv[i] << ": " << (!valid ? "INVALID" : result.won ? "won" : result.lost ? "lost" : "unfinished")
+                 << ", " << result.rows << "x" << result.cols << " with " << result.mines << " mines, "
+                 << result.events << " events, " << result.playMilliseconds << " ms" << endl;
+            valid ? verified++ : failed++;
+            continue;
+        }
+
+        for (const Score& score : scores) {
+            if (score.replay.empty()) {
+                continue;
+            }
+            auto start = chrono::steady_clock::now();
+            string problem = verify(player, score);
+            seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (problem.empty()) {
+                verified++;
+            }
+            else {
+                failed++;
+                cout << argv[i] << ": " << score.name << " (" << score.seconds << " s on " << score.rows << "x"
+                     << score.cols << ", " << score.mines << " mines): " << problem << endl;
+            }
+        }
+    }
+
+    cout << verified << " verified, " << failed << " failed";
+    if (seconds > 0) {
+        cout << ", " << (verified + failed) / seconds * 60 << " replays/min";
+    }
+    cout << endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// One timed span: a phase of a frame, an action, or the time from a click to the frame that shows it
+struct TraceEvent {
+    const char* name = nullptr;     // A string literal, so events never own memory
+    uint64_t start = 0;             // Nanoseconds since the tracer started
+    uint64_t duration = 0;          // Nanoseconds
+    uint32_t thread = 0;            // Small id of the recording thread, in the order threads first recorded
+};
+
+// Records timed spans into a fixed ring buffer, keeping the most recent CAPACITY of them. Recording takes a
+// ticket with one atomic increment and never locks or allocates, so any thread can record while another
+// reads. Each slot carries a sequence number that is odd while the slot is being written, and a reader
+// keeps a copy of a slot only if its sequence was even and unchanged around the copy. The fields are relaxed
+// atomics, so a torn copy is discarded rather than undefined.
+// The events can be written as Chrome trace JSON, which chrome://tracing and ui.perfetto.dev open, and
+// summarized as the 50th and 99th percentile duration of each name.
+class Tracer {
+public:
+    static const int CAPACITY = 1 << 16;        // Events kept, about 2.5 MB
+
+    atomic<bool> enabled{true};
+    chrono::steady_clock::time_point origin = chrono::steady_clock::now();
+
+    // Click to present latency, kept by the main loop only. It marks when it reads a click and when the next
+    // frame is shown.
+    uint64_t pendingInput = 0;          // Time the oldest click not yet shown was read, 0 if none
+    double lastInputLatency = 0;        // Milliseconds from the last shown click to its frame
+
+    // Frames per second, counted over windows of about a second
+    uint64_t fpsWindowStart = 0;
+    int fpsWindowFrames = 0;
+    double framesPerSecond = 0;
+
+    Tracer() : slots(new Slot[CAPACITY]) {}
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    uint64_t now() const {
+        return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin).count();
+    }
+
+    void record(const char* name, uint64_t start, uint64_t end) {
+        if (!enabled.load(memory_order_relaxed)) {
+            return;
+        }
+        uint64_t ticket = nextTicket.fetch_add(1, memory_order_relaxed);
+        Slot& slot = slots[ticket % CAPACITY];
+        slot.sequence.store(ticket * 2 + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        slot.name.store(name, memory_order_relaxed);
+        slot.start.store(start, memory_order_relaxed);
+        slot.duration.store(end > start ? end - start : 0, memory_order_relaxed);
+        slot.thread.store(threadId(), memory_order_relaxed);
+        slot.sequence.store(ticket * 2 + 2, memory_order_release);
+    }
+
+    // A click was read. Only the first click before a frame is timed, as the frame shows them all.
+    void markInput() {
+        if (pendingInput == 0) {
+            pendingInput = max<uint64_t>(now(), 1);
+        }
+    }
+
+    // A frame was shown
+    void markPresent() {
+        uint64_t end = now();
+        if (pendingInput != 0) {
+            record("click_to_present", pendingInput, end);
+            lastInputLatency = (double)(end - pendingInput) / 1e6;
+            pendingInput = 0;
+        }
+        fpsWindowFrames++;
+        if (end - fpsWindowStart >= 1000000000ull) {
+            framesPerSecond = fpsWindowFrames * 1e9 / (double)(end - fpsWindowStart);
+            fpsWindowStart = end;
+            fpsWindowFrames = 0;
+        }
+    }
+
+    // The events still in the ring, oldest first. Slots being written during the copy are skipped.
+    vector<TraceEvent> events() const {
+        vector<TraceEvent> result;
+        uint64_t end = nextTicket.load(memory_order_acquire);
+        uint64_t begin = end > (uint64_t)CAPACITY ? end - CAPACITY : 0;
+        result.reserve((size_t)(end - begin));
+        for (uint64_t ticket = begin; ticket < end; ticket++) {
+            const Slot& slot = slots[ticket % CAPACITY];
+            uint64_t before = slot.sequence.load(memory_order_acquire);
+            if (before != ticket * 2 + 2) {
+                continue;
+            }
+            TraceEvent event;
+            event.name = slot.name.load(memory_order_relaxed);
+            event.start = slot.start.load(memory_order_relaxed);
+            event.duration = slot.duration.load(memory_order_relaxed);
+            event.thread = slot.thread.load(memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            if (slot.sequence.load(memory_order_relaxed) == before) {
+                result.push_back(event);
+            }
+        }
+        return result;
+    }
+
+    // Chrome trace event format, with times in microseconds
+    string chromeTraceJson() const {
+        ostringstream json;
+        json << fixed;
+        json.precision(3);
+        json << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        vector<TraceEvent> recorded = events();
+        for (size_t i = 0; i < recorded.size(); i++) {
+            const TraceEvent& event = recorded[i];
+            json << "  {\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.thread
+                 << ", \"ts\": " << event.start / 1000.0 << ", \"dur\": " << event.duration / 1000.0 << "}"
+                 << (i + 1 < recorded.size() ? "," : "") << "\n";
+        }
+        json << "]}\n";
+        return json.str();
+    }
+
+    bool writeChromeTrace(const string& path) const {
+        ofstream outfile(path);
+        if (!outfile) {
+            return false;
+        }
+        outfile << chromeTraceJson();
+        return (bool)outfile;
+    }
+
+    // One line per event name: count, p50, p99 and maximum duration in milliseconds
+    string summary() const {
+        map<string, vector<uint64_t>> durations;
+        for (const TraceEvent& event : events()) {
+            durations[event.name].push_back(event.duration);
+        }
+        ostringstream text;
+        for (auto& [name, values] : durations) {
+            sort(values.begin(), values.end());
+            text << "  " << name << ": " << values.size() << " events, p50 " << percentile(values, 0.50) / 1e6
+                 << " ms, p99 " << percentile(values, 0.99) / 1e6 << " ms, max " << values.back() / 1e6 << " ms\n";
+        }
+        return text.str();
+    }
+
+private:
+    struct Slot {
+        atomic<uint64_t> sequence{0};
+        atomic<const char*> name{nullptr};
+        atomic<uint64_t> start{0};
+        atomic<uint64_t> duration{0};
+        atomic<uint32_t> thread{0};
+    };
+
+    unique_ptr<Slot[]> slots;
+    atomic<uint64_t> nextTicket{0};
+    atomic<uint32_t> threadCount{0};
+
+    uint32_t threadId() {
+        thread_local uint32_t id = threadCount.fetch_add(1, memory_order_relaxed);
+        return id;
+    }
+
+    // Nearest rank of sorted values
+    static double percentile(const vector<uint64_t>& sorted, double fraction) {
+        size_t rank = (size_t)ceil(fraction * (double)sorted.size());
+        return (double)sorted[min(max(rank, (size_t)1), sorted.size()) - 1];
+    }
+};
+
+// The tracer shared by the whole program
+inline Tracer& tracer() {
+    static Tracer instance;
+    return instance;
+}
+
+// Records the time from its construction to the end of its scope
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(name), start(tracer().now()) {}
+
+    ~TraceScope() {
+        tracer().record(name, start, tracer().now());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    uint64_t start;
+};